@@ -4,19 +4,46 @@
  */
 
 #include "heap.h"
+#include "heap_array.h"
+#include "heap_pairing.h"
+#include "heap_timer.h"
+#include "heap_pool.h"
+#include "heap_merge.h"
+#include "heap_minmax.h"
+#include "heap_snap.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include <sys/times.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #define HEAP_DEBUG  0
 #define TEST_LEN    1000000
+#define TEST_BATCH  256
+#define TEST_REPLACE 100000
+#define TEST_SCALE_MIN 10000
+#define TEST_RUNS   1000
+#define TEST_TOPK   1000
+#define TEST_RUN_LEN 1000
+#define TEST_SCALE_MAX 10000000
+#define TEST_SNAP   10000000
 
 struct bench_node {
     struct heap_node node;
     unsigned int num;
     unsigned int data;
+    bool dead;
+};
+
+/* 16-byte payload addressed by number from an index heap */
+struct bench_entry {
+    unsigned int data;
+    unsigned int num;
+    unsigned long long stamp;
 };
 
 #define heap_to_bench(ptr) \
@@ -37,6 +64,7 @@ static void node_dump(struct bench_node *bnode)
 #endif
 
 static HEAP_ROOT(bench_root);
+static struct heap_timer_base bench_timer;
 
 static void time_dump(int ticks, clock_t start, clock_t stop, struct tms *start_tms, struct tms *stop_tms)
 {
@@ -45,6 +73,62 @@ static void time_dump(int ticks, clock_t start, clock_t stop, struct tms *start_
     printf("  kern time: %lf\n", (stop_tms->tms_stime - start_tms->tms_stime) / (double)ticks);
 }
 
+static void cost_dump(int ticks, clock_t start, clock_t stop, unsigned int nodes)
+{
+    printf("  per node: %lf ns\n", (stop - start) * 1e9 / ticks / nodes);
+}
+
+static int misses_open(void)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void misses_start(int fd)
+{
+    if (fd < 0)
+        return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static void misses_dump(int fd, unsigned int ops)
+{
+    unsigned long long misses;
+
+    if (fd < 0 || ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) ||
+        read(fd, &misses, sizeof(misses)) != sizeof(misses)) {
+        printf("  misses per pop: unavailable\n");
+        return;
+    }
+
+    printf("  misses per pop: %lf\n", misses / (double)ops);
+}
+
+#ifdef HEAP_STATS
+static void stats_dump(struct heap_stats *stats, unsigned int ops)
+{
+    printf("  cmps per op: %lf\n", stats->cmps / (double)ops);
+    printf("  swaps per op: %lf\n", stats->swaps / (double)ops);
+    printf("  sift up: %lu passes, %lf levels\n", stats->fixups,
+           stats->fixups ? stats->ups / (double)stats->fixups : 0);
+    printf("  sift down: %lu passes, %lf levels\n", stats->fixdowns,
+           stats->fixdowns ? stats->downs / (double)stats->fixdowns : 0);
+    printf("  max depth: %u\n", stats->depth);
+}
+#else
+# define stats_dump(stats, ops) ((void)0)
+#endif
+
 static unsigned int test_deepth(struct heap_node *node)
 {
     unsigned int left_deepth, right_deepth;
@@ -64,16 +148,447 @@ static long bench_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
     return nodea->data < nodeb->data ? -1 : 1;
 }
 
-int main(void)
+HEAP_DEFINE(static inline, bench, bench_cmp)
+
+static long bench_timer_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    struct heap_timer *timera = heap_to_timer(hpa);
+    struct heap_timer *timerb = heap_to_timer(hpb);
+    return timera->expires < timerb->expires ? -1 : 1;
+}
+
+static bool bench_dead(const struct heap_node *hpnode, void *pdata)
+{
+    return heap_to_bench(hpnode)->dead;
+}
+
+static void bench_release(struct heap_node *hpnode, void *pdata)
+{
+    heap_to_bench(hpnode)->dead = false;
+}
+
+static long bench_entry_cmp(const void *nodea, const void *nodeb)
+{
+    const struct bench_entry *entrya = nodea;
+    const struct bench_entry *entryb = nodeb;
+    return entrya->data < entryb->data ? -1 : 1;
+}
+
+static void bench_destroy(struct heap_node *hpnode, void *pdata)
+{
+    unsigned int *count = pdata;
+
+    node_dump(heap_to_bench(hpnode));
+    (*count)++;
+}
+
+static long bench_array_cmp(const void *nodea, const void *nodeb)
+{
+    const struct bench_node *bnodea = nodea;
+    const struct bench_node *bnodeb = nodeb;
+    return bnodea->data < bnodeb->data ? -1 : 1;
+}
+
+/* FIFO within a coarse priority, tie broken by insertion number */
+#define bench_priority(bnode) ((bnode)->data >> 24)
+
+static long bench_stable_cmp(const void *nodea, const void *nodeb)
+{
+    const struct bench_node *bnodea = nodea;
+    const struct bench_node *bnodeb = nodeb;
+
+    if (bench_priority(bnodea) != bench_priority(bnodeb))
+        return bench_priority(bnodea) < bench_priority(bnodeb) ? -1 : 1;
+    return bnodea->num < bnodeb->num ? -1 : 1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+# define SCALE_UNIT "cycles"
+static inline unsigned long long scale_clock(void)
 {
-    struct bench_node *bnode;
+    return __builtin_ia32_rdtsc();
+}
+#else
+# define SCALE_UNIT "ns"
+static inline unsigned long long scale_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+static int bench_scale(unsigned long limit)
+{
+    struct bench_node *bnodes, *bnode;
+    unsigned long long start, insert, replace, delete;
+    unsigned long length, count;
+    HEAP_ROOT(root);
+
+    printf("Descent Scaling (prefetch %s):\n", HEAP_PREFETCH ? "on" : "off");
+    for (length = TEST_SCALE_MIN; length <= limit; length *= 10) {
+        bnodes = malloc(length * sizeof(*bnodes));
+        if (!bnodes) {
+            printf("Insufficient Memory!\n");
+            return 1;
+        }
+
+        for (count = 0; count < length; ++count)
+            bnodes[count].data = rand();
+
+        start = scale_clock();
+        for (count = 0; count < length; ++count)
+            heap_insert(&root, &bnodes[count].node, bench_cmp);
+        insert = scale_clock() - start;
+
+        /* replace in place so the heap keeps its size */
+        start = scale_clock();
+        for (count = 0; count < TEST_REPLACE; ++count) {
+            bnode = heap_to_bench(root.node);
+            bnode->data = rand();
+            heap_fixdown(&root, &bnode->node, bench_cmp);
+        }
+        replace = scale_clock() - start;
+
+        start = scale_clock();
+        while (root.node)
+            heap_delete(&root, root.node, bench_cmp);
+        delete = scale_clock() - start;
+
+        printf("  %9lu nodes: insert %8.1lf, replace %8.1lf, delete %8.1lf " SCALE_UNIT "/op\n",
+               length, (double)insert / length, (double)replace / TEST_REPLACE,
+               (double)delete / length);
+        free(bnodes);
+    }
+
+    return 0;
+}
+
+static long bench_merge_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    const unsigned long *keya = HEAP_MERGE_RECORD(heap_to_cursor(hpa));
+    const unsigned long *keyb = HEAP_MERGE_RECORD(heap_to_cursor(hpb));
+    return *keya < *keyb ? -1 : 1;
+}
+
+static int bench_merge_check(struct heap_merge *merge, unsigned long *total)
+{
+    const unsigned long *key;
+    unsigned long last = 0;
+
+    for (*total = 0; (key = heap_merge_next(merge, bench_merge_cmp)); ++*total) {
+        if (*key < last)
+            return 1;
+        last = *key;
+    }
+
+    return 0;
+}
+
+static int bench_merge(int ticks)
+{
+    struct heap_merge_cursor *cursors, *cursor;
+    struct heap_merge_map *maps;
+    unsigned long *runs, total, last;
     struct tms start_tms, stop_tms;
     clock_t start, stop;
-    unsigned int count, ticks;
+    unsigned int run, count;
+    FILE *file = NULL;
+    int ret = 1;
+
+    HEAP_MERGE(merge, sizeof(*runs));
+    HEAP_ROOT(root);
+
+    runs = malloc(TEST_RUNS * TEST_RUN_LEN * sizeof(*runs));
+    cursors = malloc(TEST_RUNS * sizeof(*cursors));
+    maps = malloc(TEST_RUNS * sizeof(*maps));
+    if (!runs || !cursors || !maps) {
+        printf("Insufficient Memory!\n");
+        goto error;
+    }
+
+    /* each run ascends from a random point in small random steps */
+    for (run = 0; run < TEST_RUNS; ++run) {
+        last = rand();
+        for (count = 0; count < TEST_RUN_LEN; ++count)
+            runs[run * TEST_RUN_LEN + count] = last += rand() & 0xffff;
+    }
+
+    printf("Merge Delete and Insert (%u runs):\n", TEST_RUNS);
+    for (run = 0; run < TEST_RUNS; ++run) {
+        heap_merge_buffer(&cursors[run], &runs[run * TEST_RUN_LEN], TEST_RUN_LEN * sizeof(*runs));
+        heap_insert(&root, &cursors[run].node, bench_merge_cmp);
+    }
+    start = times(&start_tms);
+    for (total = 0; root.node; ++total) {
+        cursor = heap_to_cursor(root.node);
+        heap_delete(&root, &cursor->node, bench_merge_cmp);
+        if ((cursor->pos += sizeof(*runs)) != cursor->end)
+            heap_insert(&root, &cursor->node, bench_merge_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, total);
+
+    printf("Merge Replace Top (%u runs):\n", TEST_RUNS);
+    for (run = 0; run < TEST_RUNS; ++run) {
+        heap_merge_buffer(&cursors[run], &runs[run * TEST_RUN_LEN], TEST_RUN_LEN * sizeof(*runs));
+        heap_merge_add(&merge, &cursors[run], bench_merge_cmp);
+    }
+    start = times(&start_tms);
+    if (bench_merge_check(&merge, &total)) {
+        printf("  merge out of order!\n");
+        goto error;
+    }
+    stop = times(&stop_tms);
+    printf("  total num: %lu\n", total);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, total);
+
+    printf("Merge Mapped (%u runs):\n", TEST_RUNS);
+    if (!(file = tmpfile()) ||
+        fwrite(runs, sizeof(*runs), TEST_RUNS * TEST_RUN_LEN, file) != TEST_RUNS * TEST_RUN_LEN ||
+        fflush(file)) {
+        printf("  temporary file unavailable\n");
+        goto error;
+    }
+    for (run = 0; run < TEST_RUNS; ++run) {
+        if (heap_merge_map_init(&maps[run], fileno(file), run * TEST_RUN_LEN * sizeof(*runs),
+                                TEST_RUN_LEN * sizeof(*runs), 64 * sizeof(*runs))) {
+            printf("  mapping failed\n");
+            while (run--)
+                heap_merge_map_release(&maps[run]);
+            goto error;
+        }
+        heap_merge_add(&merge, &maps[run].cursor, bench_merge_cmp);
+    }
+    start = times(&start_tms);
+    ret = bench_merge_check(&merge, &total);
+    stop = times(&stop_tms);
+    if (ret)
+        printf("  merge out of order!\n");
+    printf("  total num: %lu\n", total);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, total);
+
+    for (run = 0; run < TEST_RUNS; ++run)
+        heap_merge_map_release(&maps[run]);
+
+error:
+    if (file)
+        fclose(file);
+    free(runs);
+    free(cursors);
+    free(maps);
+    return ret;
+}
+
+/* deadline entry queued on both ends, by two heaps or one min-max heap */
+struct bench_dual {
+    struct heap_node min;
+    struct heap_node max;
+    unsigned int num;
+};
+
+static long bench_dual_min_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    struct bench_dual *nodea = heap_entry(hpa, struct bench_dual, min);
+    struct bench_dual *nodeb = heap_entry(hpb, struct bench_dual, min);
+    return nodea->num < nodeb->num ? -1 : 1;
+}
+
+static long bench_dual_max_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    struct bench_dual *nodea = heap_entry(hpa, struct bench_dual, max);
+    struct bench_dual *nodeb = heap_entry(hpb, struct bench_dual, max);
+    return nodea->num > nodeb->num ? -1 : 1;
+}
+
+static void bench_snap_save(const struct heap_node *hpnode, struct heap_snap_record *record, void *pdata)
+{
+    struct bench_node *bnode = heap_to_bench(hpnode);
+
+    record->key = bnode->data;
+    record->id = bnode->num;
+}
+
+static struct heap_node *bench_snap_load(const struct heap_snap_record *record, void *pdata)
+{
+    struct bench_node *bnode = (struct bench_node *)pdata + record->id;
+
+    bnode->data = record->key;
+    return &bnode->node;
+}
+
+static int bench_snap(int ticks, unsigned int length)
+{
+    struct tms start_tms, stop_tms;
+    struct bench_node *bnodes;
+    clock_t start, stop;
+    unsigned int count;
+    FILE *file;
+    int ret = 1;
+
+    HEAP_ROOT(root);
+
+    bnodes = malloc(length * sizeof(*bnodes));
+    if (!bnodes) {
+        printf("Insufficient Memory!\n");
+        return 1;
+    }
+
+    if (!(file = tmpfile())) {
+        printf("  temporary file unavailable\n");
+        goto error;
+    }
+
+    printf("Snapshot Reinsert %u bnode:\n", length);
+    start = times(&start_tms);
+    for (count = 0; count < length; ++count) {
+        bnodes[count].num = count;
+        bnodes[count].data = rand();
+        bench_insert(&root, &bnodes[count].node);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, length);
+
+    printf("Snapshot Save %u bnode:\n", length);
+    start = times(&start_tms);
+    if (heap_snap_save(&root, fileno(file), bench_snap_save, NULL)) {
+        printf("  save failed\n");
+        goto error;
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, length);
+
+    printf("Snapshot Load %u bnode:\n", length);
+    count = heap_to_bench(root.node)->data;
+    heap_clear(&root);
+    start = times(&start_tms);
+    if (heap_snap_load(&root, fileno(file), bench_snap_load, bnodes)) {
+        printf("  load failed\n");
+        goto error;
+    }
+    stop = times(&stop_tms);
+    printf("  first: 0x%8x\n", heap_to_bench(root.node)->data);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, length);
+
+    ret = count != heap_to_bench(root.node)->data || root.count != length;
+    if (ret)
+        printf("  snapshot mismatch!\n");
+
+error:
+    if (file)
+        fclose(file);
+    free(bnodes);
+    return ret;
+}
+
+static int bench_minmax(int ticks)
+{
+    struct tms start_tms, stop_tms;
+    struct bench_dual *duals, *dual;
+    clock_t start, stop;
+    unsigned int count;
+
+    HEAP_ROOT(min_root);
+    HEAP_ROOT(max_root);
+
+    duals = malloc(TEST_LEN * sizeof(*duals));
+    if (!duals) {
+        printf("Insufficient Memory!\n");
+        return 1;
+    }
+
+    for (count = 0; count < TEST_LEN; ++count)
+        duals[count].num = rand();
+
+    printf("Two Heaps Insert and Pop Both Ends:\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count) {
+        heap_insert(&min_root, &duals[count].min, bench_dual_min_cmp);
+        heap_insert(&max_root, &duals[count].max, bench_dual_max_cmp);
+    }
+    for (count = 0; count < TEST_LEN; ++count) {
+        if (count & 1)
+            dual = heap_entry(max_root.node, struct bench_dual, max);
+        else
+            dual = heap_entry(min_root.node, struct bench_dual, min);
+        heap_delete(&min_root, &dual->min, bench_dual_min_cmp);
+        heap_delete(&max_root, &dual->max, bench_dual_max_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Min-max Insert and Pop Both Ends:\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_minmax_insert(&min_root, &duals[count].min, bench_dual_min_cmp);
+    for (count = 0; count < TEST_LEN; ++count) {
+        if (count & 1)
+            heap_minmax_pop_max(&min_root, bench_dual_min_cmp);
+        else
+            heap_minmax_pop_min(&min_root, bench_dual_min_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    free(duals);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_node *bnode, **table, spare;
+    struct heap_pairing pairing, pshard;
+    struct heap_root_cached cached;
+    struct heap_root shard;
+    struct heap_pool pool;
+    struct heap_pool_cache cache;
+    struct heap_lazy lazy;
+    struct heap_bounded bounded;
+    struct heap_timer *timers;
+    unsigned long now, limit;
+    struct heap_array array, dary;
+    struct heap_index index32;
+    struct heap_keyed keyed, kdary;
+    struct heap_keyed_slot *kslots, *kdslots;
+    struct bench_entry *entries;
+    uint32_t *slots, *where;
+    struct heap_node **build;
+    void **nodes, **dnodes;
+    int misses;
+    struct tms start_tms, stop_tms;
+    clock_t start, stop;
+    unsigned int count, dead, ticks;
     unsigned long index;
     int ret = 0;
 
     ticks = sysconf(_SC_CLK_TCK);
+    misses = misses_open();
+    table = calloc(TEST_LEN, sizeof(*table));
+    nodes = malloc(TEST_LEN * sizeof(*nodes));
+    dnodes = aligned_alloc(HEAP_DARY_ALIGN, HEAP_DARY_SIZE(TEST_LEN) * sizeof(*dnodes));
+    build = malloc(TEST_LEN * sizeof(*build));
+    timers = malloc(TEST_LEN * sizeof(*timers));
+    entries = malloc(TEST_LEN * sizeof(*entries));
+    slots = malloc(TEST_LEN * sizeof(*slots));
+    where = malloc(TEST_LEN * sizeof(*where));
+    kslots = malloc(TEST_LEN * sizeof(*kslots));
+    kdslots = aligned_alloc(HEAP_DARY_ALIGN, HEAP_KEYED_DARY_SIZE(TEST_LEN) * sizeof(*kdslots));
+    if ((ret = !table || !nodes || !dnodes || !build || !timers ||
+         !entries || !slots || !where || !kslots || !kdslots)) {
+        printf("Insufficient Memory!\n");
+        goto error;
+    }
+    array = HEAP_ARRAY_INIT(nodes, TEST_LEN);
+    heap_dary_init(&dary, dnodes, HEAP_DARY_SIZE(TEST_LEN));
 
     printf("Generate %u bnode:\n", TEST_LEN);
     start = times(&start_tms);
@@ -86,37 +601,547 @@ int main(void)
 
         bnode->num = count + 1;
         bnode->data = rand();
+        table[count] = bnode;
 
 #if HEAP_DEBUG
         printf("  %08d: 0x%8x\n", bnode->num, bnode->data);
 #endif
-
-        heap_insert(&bench_root, &bnode->node, bench_cmp);
     }
     stop = times(&stop_tms);
     time_dump(ticks, start, stop, &start_tms, &stop_tms);
 
+    printf("Generic Insert:\n");
+    heap_stats_reset(&bench_root.stats);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_insert(&bench_root, &table[count]->node, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&bench_root.stats, TEST_LEN);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
     count = test_deepth(bench_root.node);
     printf("  heap deepth: %u\n", count);
 
     start = times(&start_tms);
-    count = 0;
+    count = dead = 0;
     printf("Levelorder Iteration:\n");
     heap_for_each_entry(bnode, &index, &bench_root, node) {
         node_dump(bnode);
         count++;
+        dead += bnode->dead;
     }
     stop = times(&stop_tms);
-    printf("  total num: %u\n", count);
+    printf("  total num: %u (%u dead)\n", count, dead);
     time_dump(ticks, start, stop, &start_tms, &stop_tms);
 
-    printf("Deletion All bnode...\n");
-error:
+    printf("Pop and Insert (%u times):\n", TEST_REPLACE);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_REPLACE; ++count) {
+        bnode = heap_to_bench(bench_root.node);
+        heap_delete(&bench_root, &bnode->node, bench_cmp);
+        bnode->data = rand();
+        heap_insert(&bench_root, &bnode->node, bench_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_REPLACE);
+
+    printf("Replace Top (%u times):\n", TEST_REPLACE);
+    bnode = &spare;
+    start = times(&start_tms);
+    for (count = 0; count < TEST_REPLACE; ++count) {
+        bnode->data = rand();
+        bnode = heap_to_bench(heap_pushpop(&bench_root, &bnode->node, bench_cmp));
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_REPLACE);
+
+    if (bnode != &spare)
+        heap_replace(&bench_root, &spare.node, &bnode->node, bench_cmp);
+
+    printf("Delete and Insert (%u times):\n", TEST_REPLACE);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_REPLACE; ++count) {
+        bnode = table[rand() % TEST_LEN];
+        heap_delete(&bench_root, &bnode->node, bench_cmp);
+        bnode->data = rand();
+        heap_insert(&bench_root, &bnode->node, bench_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_REPLACE);
+
+    printf("Update (%u times):\n", TEST_REPLACE);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_REPLACE; ++count) {
+        bnode = table[rand() % TEST_LEN];
+        bnode->data = rand();
+        heap_update(&bench_root, &bnode->node, bench_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_REPLACE);
+
+    printf("Generic Deletion:\n");
+    heap_stats_reset(&bench_root.stats);
+    start = times(&start_tms);
     while (bench_root.count) {
         bnode = heap_to_bench(bench_root.node);
         node_dump(bnode);
         heap_delete(&bench_root, &bnode->node, bench_cmp);
     }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&bench_root.stats, TEST_LEN);
+
+    printf("Cached Insert:\n");
+    cached = HEAP_CACHED_INIT;
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_cached_insert(&cached, &table[count]->node, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Cached Deletion:\n");
+    start = times(&start_tms);
+    while (cached.root.count)
+        heap_cached_delete(&cached, cached.root.node, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Specialized Insert:\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        bench_insert(&bench_root, &table[count]->node);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Specialized Deletion:\n");
+    start = times(&start_tms);
+    while (bench_root.count) {
+        bnode = heap_to_bench(bench_root.node);
+        node_dump(bnode);
+        bench_delete(&bench_root, &bnode->node);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Generic Build:\n");
+    for (count = 0; count < TEST_LEN; ++count)
+        build[count] = &table[count]->node;
+    start = times(&start_tms);
+    heap_build(&bench_root, build, TEST_LEN, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    count = test_deepth(bench_root.node);
+    printf("  heap deepth: %u\n", count);
+
+    printf("Generic Deletion:\n");
+    start = times(&start_tms);
+    while (bench_root.count) {
+        bnode = heap_to_bench(bench_root.node);
+        node_dump(bnode);
+        heap_delete(&bench_root, &bnode->node, bench_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Postorder Destroy:\n");
+    heap_build(&bench_root, build, TEST_LEN, bench_cmp);
+    count = 0;
+    start = times(&start_tms);
+    heap_destroy(&bench_root, bench_destroy, &count);
+    stop = times(&stop_tms);
+    printf("  total num: %u\n", count);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Batch Insert (%u nodes):\n", TEST_BATCH);
+    for (count = 0; count < TEST_LEN; ++count)
+        build[count] = &table[count]->node;
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; count += TEST_BATCH)
+        heap_insert_batch(&bench_root, build + count, TEST_LEN - count < TEST_BATCH ?
+                          TEST_LEN - count : TEST_BATCH, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Batch Deletion (%u nodes):\n", TEST_BATCH);
+    start = times(&start_tms);
+    while (heap_pop_batch(&bench_root, build, TEST_BATCH, bench_cmp))
+        ;
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Pairing Insert:\n");
+    heap_stats_reset(&pairing.stats);
+    pairing = HEAP_PAIRING_INIT;
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_pairing_insert(&pairing, &table[count]->node, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&pairing.stats, TEST_LEN);
+
+    printf("Pairing Deletion:\n");
+    heap_stats_reset(&pairing.stats);
+    start = times(&start_tms);
+    while (heap_pairing_pop(&pairing, bench_cmp))
+        ;
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&pairing.stats, TEST_LEN);
+
+    printf("Shard Meld (%u nodes):\n", TEST_LEN / 2);
+    pshard = HEAP_PAIRING_INIT;
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_pairing_insert(count & 1 ? &pshard : &pairing, &table[count]->node, bench_cmp);
+    start = times(&start_tms);
+    heap_pairing_meld(&pairing, &pshard, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    while (heap_pairing_pop(&pairing, bench_cmp))
+        ;
+
+    printf("Shard Pop and Insert (%u nodes):\n", TEST_LEN / 2);
+    shard = HEAP_INIT;
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_insert(count & 1 ? &shard : &bench_root, &table[count]->node, bench_cmp);
+    start = times(&start_tms);
+    while (shard.count) {
+        bnode = heap_to_bench(shard.node);
+        heap_delete(&shard, &bnode->node, bench_cmp);
+        heap_insert(&bench_root, &bnode->node, bench_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    while (bench_root.count)
+        heap_delete(&bench_root, bench_root.node, bench_cmp);
+
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_insert(&bench_root, &table[count]->node, bench_cmp);
+
+    printf("Eager Cancel (70%%):\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        if (count % 10 < 7)
+            heap_delete(&bench_root, &table[count]->node, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Eager Drain:\n");
+    start = times(&start_tms);
+    while (bench_root.count)
+        heap_delete(&bench_root, bench_root.node, bench_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    lazy = HEAP_LAZY_INIT(bench_dead, bench_release, NULL);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_lazy_insert(&lazy, &table[count]->node, bench_cmp);
+
+    printf("Lazy Cancel (70%%):\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count) {
+        if (count % 10 < 7) {
+            table[count]->dead = true;
+            heap_lazy_cancel(&lazy, &table[count]->node, bench_cmp);
+        }
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    printf("  live nodes: %u\n", HEAP_LAZY_LIVE(&lazy));
+    printf("  dead nodes: %u\n", HEAP_LAZY_DEAD(&lazy));
+
+    printf("Lazy Drain:\n");
+    start = times(&start_tms);
+    while (heap_lazy_pop(&lazy, bench_cmp))
+        ;
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    for (count = 0; count < TEST_LEN; ++count)
+        timers[count].expires = 100 + rand() % 29900;
+
+    printf("Timer Heap Add:\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_insert(&bench_root, &timers[count].node, bench_timer_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Timer Heap Cancel (90%%):\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        if (count % 10)
+            heap_delete(&bench_root, &timers[count].node, bench_timer_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Timer Heap Expire:\n");
+    start = times(&start_tms);
+    for (now = 0; now <= 30000; ++now) {
+        while (bench_root.node && heap_to_timer(bench_root.node)->expires <= now)
+            heap_delete(&bench_root, bench_root.node, bench_timer_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    heap_timer_init(&bench_timer, 0);
+    printf("Timer Wheel Add:\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_timer_add(&bench_timer, &timers[count]);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Timer Wheel Cancel (90%%):\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        if (count % 10)
+            heap_timer_cancel(&bench_timer, &timers[count]);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Timer Wheel Expire:\n");
+    start = times(&start_tms);
+    for (now = 0; now <= 30000; ++now) {
+        while (heap_timer_expire(&bench_timer, now))
+            ;
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Array Insert:\n");
+    heap_stats_reset(&array.stats);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_array_insert(&array, table[count], bench_array_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&array.stats, TEST_LEN);
+
+    start = times(&start_tms);
+    count = 0;
+    printf("Array Levelorder Iteration:\n");
+    heap_array_for_each(bnode, index, &array) {
+        node_dump(bnode);
+        count++;
+    }
+    stop = times(&stop_tms);
+    printf("  total num: %u\n", count);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    printf("Array Deletion:\n");
+    heap_stats_reset(&array.stats);
+    misses_start(misses);
+    start = times(&start_tms);
+    while (!HEAP_ARRAY_EMPTY(&array))
+        heap_array_pop(&array, bench_array_cmp);
+    stop = times(&stop_tms);
+    misses_dump(misses, TEST_LEN);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&array.stats, TEST_LEN);
+
+    printf("D-ary (%u ways) Insert:\n", HEAP_DARY_WAYS);
+    heap_stats_reset(&dary.stats);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_dary_insert(&dary, table[count], bench_array_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&dary.stats, TEST_LEN);
+
+    printf("D-ary (%u ways) Deletion:\n", HEAP_DARY_WAYS);
+    heap_stats_reset(&dary.stats);
+    misses_start(misses);
+    start = times(&start_tms);
+    while (!HEAP_ARRAY_EMPTY(&dary))
+        heap_dary_pop(&dary, bench_array_cmp);
+    stop = times(&stop_tms);
+    misses_dump(misses, TEST_LEN);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&dary.stats, TEST_LEN);
+
+    printf("Keyed Insert:\n");
+    keyed = HEAP_KEYED_INIT(kslots, TEST_LEN);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_keyed_insert(&keyed, table[count]->data, table[count]);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&keyed.stats, TEST_LEN);
+
+    printf("Keyed Deletion:\n");
+    heap_stats_reset(&keyed.stats);
+    misses_start(misses);
+    start = times(&start_tms);
+    while (!HEAP_KEYED_EMPTY(&keyed))
+        heap_keyed_pop(&keyed);
+    stop = times(&stop_tms);
+    misses_dump(misses, TEST_LEN);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&keyed.stats, TEST_LEN);
+
+    printf("Keyed D-ary (%u ways) Insert:\n", HEAP_KEYED_WAYS);
+    heap_keyed_dary_init(&kdary, kdslots, HEAP_KEYED_DARY_SIZE(TEST_LEN));
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_keyed_dary_insert(&kdary, table[count]->data, table[count]);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&kdary.stats, TEST_LEN);
+
+    printf("Keyed D-ary (%u ways) Deletion:\n", HEAP_KEYED_WAYS);
+    heap_stats_reset(&kdary.stats);
+    misses_start(misses);
+    start = times(&start_tms);
+    while (!HEAP_KEYED_EMPTY(&kdary))
+        heap_keyed_dary_pop(&kdary);
+    stop = times(&stop_tms);
+    misses_dump(misses, TEST_LEN);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&kdary.stats, TEST_LEN);
+
+    printf("Stable Array Insert and Deletion:\n");
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_array_insert(&array, table[count], bench_stable_cmp);
+    while (!HEAP_ARRAY_EMPTY(&array))
+        heap_array_pop(&array, bench_stable_cmp);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Stable Keyed Insert and Deletion:\n");
+    keyed = HEAP_KEYED_INIT(kslots, TEST_LEN);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_keyed_stable_insert(&keyed, bench_priority(table[count]), table[count]);
+    while (!HEAP_KEYED_EMPTY(&keyed))
+        heap_keyed_pop(&keyed);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Index Insert:\n");
+    heap_index_init(&index32, slots, where, TEST_LEN, entries, sizeof(*entries));
+    for (count = 0; count < TEST_LEN; ++count)
+        entries[count].data = table[count]->data;
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_index_insert(&index32, count, bench_entry_cmp);
+    stop = times(&stop_tms);
+    printf("  bytes per node: %zu (generic %zu)\n",
+           sizeof(*slots) + sizeof(*where), sizeof(struct heap_node));
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&index32.stats, TEST_LEN);
+
+    printf("Index Deletion:\n");
+    heap_stats_reset(&index32.stats);
+    misses_start(misses);
+    start = times(&start_tms);
+    while (!HEAP_INDEX_EMPTY(&index32))
+        heap_index_pop(&index32, bench_entry_cmp);
+    stop = times(&stop_tms);
+    misses_dump(misses, TEST_LEN);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    stats_dump(&index32.stats, TEST_LEN);
+
+    printf("Top-K Delete and Insert (%u of %u):\n", TEST_TOPK, TEST_LEN);
+    shard = HEAP_INIT;
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count) {
+        bnode = table[count];
+        if (shard.count < TEST_TOPK)
+            heap_insert(&shard, &bnode->node, bench_cmp);
+        else if (bench_cmp(&bnode->node, shard.node) > 0) {
+            heap_delete(&shard, shard.node, bench_cmp);
+            heap_insert(&shard, &bnode->node, bench_cmp);
+        }
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Top-K Offer (%u of %u):\n", TEST_TOPK, TEST_LEN);
+    bounded = HEAP_BOUNDED_INIT(TEST_TOPK);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_offer(&bounded, &table[count]->node, bench_cmp);
+    count = heap_bounded_extract(&bounded, build, bench_cmp);
+    stop = times(&stop_tms);
+    printf("  best: 0x%8x\n", count ? heap_to_bench(build[0])->data : 0);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Pool Generate %u bnode:\n", TEST_LEN);
+    heap_pool_init(&pool, sizeof(*bnode));
+    shard = HEAP_INIT;
+    cache = HEAP_POOL_CACHE_INIT(&pool);
+    start = times(&start_tms);
+    for (count = 0; count < TEST_LEN; ++count) {
+        bnode = heap_pool_alloc(&cache);
+        if ((ret = !bnode)) {
+            printf("Insufficient Memory!\n");
+            heap_pool_destroy(&pool);
+            goto error;
+        }
+
+        bnode->num = count + 1;
+        bnode->data = rand();
+        heap_insert(&shard, &bnode->node, bench_cmp);
+    }
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+    cost_dump(ticks, start, stop, TEST_LEN);
+
+    printf("Pool Teardown:\n");
+    start = times(&start_tms);
+    heap_clear(&shard);
+    heap_pool_destroy(&pool);
+    stop = times(&stop_tms);
+    time_dump(ticks, start, stop, &start_tms, &stop_tms);
+
+    if ((ret = bench_merge(ticks)))
+        goto error;
+
+    if ((ret = bench_minmax(ticks)))
+        goto error;
+
+    /* an optional size limit shrinks the snapshot and scaling phases */
+    limit = argc > 1 ? strtoul(argv[1], NULL, 0) : TEST_SCALE_MAX;
+    if ((ret = bench_snap(ticks, limit < TEST_SNAP ? limit : TEST_SNAP)))
+        goto error;
+
+    ret = bench_scale(limit);
+
+    printf("Deletion All bnode...\n");
+error:
+    heap_destroy(&bench_root, bench_destroy, &count);
+
+    for (count = 0; table && count < TEST_LEN && table[count]; ++count)
+        free(table[count]);
+    free(table);
+    free(nodes);
+    free(dnodes);
+    free(build);
+    free(timers);
+    free(entries);
+    free(slots);
+    free(where);
+    free(kslots);
+    free(kdslots);
+    if (misses >= 0)
+        close(misses);
 
     return ret;
 }
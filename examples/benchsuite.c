@@ -0,0 +1,353 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SUITE_MIN       100
+#define SUITE_MAX       1000000
+#define SUITE_OPS       10000
+#define SUITE_RUNS      5
+#define SUITE_WARMUP    1
+
+struct suite_node {
+    struct heap_node node;
+    uint64_t key;
+};
+
+#define heap_to_suite(ptr) \
+    heap_entry(ptr, struct suite_node, node)
+
+struct suite {
+    struct heap_root root;
+    struct suite_node *nodes;
+    struct heap_node **build;
+    unsigned long long *samples;
+    unsigned long size;
+    unsigned long ops;
+    unsigned long count;
+    uint64_t seed;
+};
+
+struct suite_work {
+    const char *name;
+    void (*run)(struct suite *suite);
+};
+
+enum suite_format {
+    SUITE_CSV,
+    SUITE_JSON,
+};
+
+static long suite_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    struct suite_node *nodea = heap_to_suite(hpa);
+    struct suite_node *nodeb = heap_to_suite(hpb);
+    return nodea->key < nodeb->key ? -1 : 1;
+}
+
+static inline unsigned long long suite_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t suite_rand(struct suite *suite)
+{
+    uint64_t seed = suite->seed;
+
+    /* xorshift64, deterministic across runs and machines */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+
+    return suite->seed = seed;
+}
+
+static inline void suite_sample(struct suite *suite, unsigned long long start)
+{
+    suite->samples[suite->count++] = suite_now() - start;
+}
+
+static void suite_fill(struct suite *suite, unsigned long count)
+{
+    unsigned long index;
+
+    suite->root = HEAP_INIT;
+    for (index = 0; index < count; ++index) {
+        suite->nodes[index].key = suite_rand(suite);
+        heap_insert(&suite->root, &suite->nodes[index].node, suite_cmp);
+    }
+}
+
+static void work_timer(struct suite *suite)
+{
+    unsigned long long start;
+    unsigned long index;
+
+    for (index = 0; index < suite->ops; ++index) {
+        start = suite_now();
+        suite_sample(suite, start);
+    }
+}
+
+static void work_insert(struct suite *suite)
+{
+    struct suite_node *node;
+    unsigned long long start;
+    unsigned long index;
+
+    suite_fill(suite, suite->size);
+    for (index = 0; index < suite->ops; ++index) {
+        node = &suite->nodes[suite->size + index];
+        node->key = suite_rand(suite);
+        start = suite_now();
+        heap_insert(&suite->root, &node->node, suite_cmp);
+        suite_sample(suite, start);
+    }
+}
+
+static void work_pop(struct suite *suite)
+{
+    unsigned long long start;
+    unsigned long index;
+
+    suite_fill(suite, suite->size + suite->ops);
+    for (index = 0; index < suite->ops; ++index) {
+        start = suite_now();
+        heap_delete(&suite->root, suite->root.node, suite_cmp);
+        suite_sample(suite, start);
+    }
+}
+
+static void work_cancel(struct suite *suite)
+{
+    unsigned long long start;
+    unsigned long index, total, pick;
+    struct heap_node *node;
+
+    total = suite->size + suite->ops;
+    suite_fill(suite, total);
+    for (index = 0; index < total; ++index)
+        suite->build[index] = &suite->nodes[index].node;
+
+    for (index = 0; index < suite->ops; ++index) {
+        /* partial shuffle, every canceled node is still queued */
+        pick = index + suite_rand(suite) % (total - index);
+        node = suite->build[pick];
+        suite->build[pick] = suite->build[index];
+        start = suite_now();
+        heap_delete(&suite->root, node, suite_cmp);
+        suite_sample(suite, start);
+    }
+}
+
+static void work_decrease(struct suite *suite)
+{
+    struct suite_node *node;
+    unsigned long long start;
+    unsigned long index;
+
+    suite_fill(suite, suite->size);
+    for (index = 0; index < suite->ops; ++index) {
+        node = &suite->nodes[suite_rand(suite) % suite->size];
+        node->key >>= 1;
+        start = suite_now();
+        heap_decrease_key(&suite->root, &node->node, suite_cmp);
+        suite_sample(suite, start);
+    }
+}
+
+static void work_replace(struct suite *suite)
+{
+    struct suite_node *node;
+    unsigned long long start;
+    unsigned long index;
+
+    suite_fill(suite, suite->size);
+    node = &suite->nodes[suite->size];
+    for (index = 0; index < suite->ops; ++index) {
+        node->key = suite_rand(suite);
+        start = suite_now();
+        node = heap_to_suite(heap_pushpop(&suite->root, &node->node, suite_cmp));
+        suite_sample(suite, start);
+    }
+}
+
+static void work_hold(struct suite *suite)
+{
+    struct suite_node *node;
+    unsigned long long start;
+    unsigned long index;
+
+    /* hold model: pop the earliest event, reschedule it a bit later */
+    suite_fill(suite, suite->size);
+    for (index = 0; index < suite->ops; ++index) {
+        start = suite_now();
+        node = heap_to_suite(suite->root.node);
+        heap_delete(&suite->root, &node->node, suite_cmp);
+        node->key += suite_rand(suite) >> 44;
+        heap_insert(&suite->root, &node->node, suite_cmp);
+        suite_sample(suite, start);
+    }
+}
+
+static void work_build(struct suite *suite)
+{
+    unsigned long long start;
+    unsigned long index;
+
+    for (index = 0; index < suite->size; ++index) {
+        suite->nodes[index].key = suite_rand(suite);
+        suite->build[index] = &suite->nodes[index].node;
+    }
+
+    suite->root = HEAP_INIT;
+    start = suite_now();
+    heap_build(&suite->root, suite->build, suite->size, suite_cmp);
+    suite->samples[suite->count++] = (suite_now() - start) / suite->size;
+}
+
+static const struct suite_work suite_works[] = {
+    {"timer", work_timer},
+    {"insert", work_insert},
+    {"pop", work_pop},
+    {"cancel", work_cancel},
+    {"decrease", work_decrease},
+    {"replace", work_replace},
+    {"hold", work_hold},
+    {"build", work_build},
+};
+
+static int sample_cmp(const void *pa, const void *pb)
+{
+    unsigned long long a = *(const unsigned long long *)pa;
+    unsigned long long b = *(const unsigned long long *)pb;
+    return a < b ? -1 : a > b;
+}
+
+static void suite_report(struct suite *suite, const char *name, unsigned int runs,
+                         enum suite_format format, bool *first)
+{
+    unsigned long long total = 0;
+    unsigned long index;
+    double mean, median, p99;
+
+    qsort(suite->samples, suite->count, sizeof(*suite->samples), sample_cmp);
+    for (index = 0; index < suite->count; ++index)
+        total += suite->samples[index];
+
+    mean = (double)total / suite->count;
+    median = suite->samples[suite->count / 2];
+    p99 = suite->samples[suite->count * 99 / 100];
+
+    if (format == SUITE_CSV) {
+        printf("%s,%lu,%u,%lu,%.1lf,%.1lf,%.1lf\n", name, suite->size,
+               runs, suite->count, mean, median, p99);
+        return;
+    }
+
+    /* github-action-benchmark customSmallerIsBetter entries */
+    printf("%s\n  {\"name\": \"%s/%lu median\", \"unit\": \"ns/op\", \"value\": %.1lf},\n"
+           "  {\"name\": \"%s/%lu p99\", \"unit\": \"ns/op\", \"value\": %.1lf}",
+           *first ? "" : ",", name, suite->size, median, name, suite->size, p99);
+    *first = false;
+}
+
+static void usage(const char *self)
+{
+    fprintf(stderr, "usage: %s [-f csv|json] [-m max] [-n min] [-r runs] [-w warmup]\n", self);
+}
+
+int main(int argc, char *argv[])
+{
+    enum suite_format format = SUITE_CSV;
+    unsigned long min = SUITE_MIN, max = SUITE_MAX;
+    unsigned int runs = SUITE_RUNS, warmup = SUITE_WARMUP;
+    unsigned int work, run;
+    struct suite suite;
+    bool first = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:m:n:r:w:")) != -1) {
+        switch (opt) {
+        case 'f':
+            if (!strcmp(optarg, "json"))
+                format = SUITE_JSON;
+            else if (strcmp(optarg, "csv")) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'm':
+            max = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            min = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            runs = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            warmup = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!min || !runs || min > max) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    memset(&suite, 0, sizeof(suite));
+    suite.nodes = malloc((max + SUITE_OPS) * sizeof(*suite.nodes));
+    suite.build = malloc((max + SUITE_OPS) * sizeof(*suite.build));
+    suite.samples = malloc(runs * SUITE_OPS * sizeof(*suite.samples));
+    if (!suite.nodes || !suite.build || !suite.samples) {
+        fprintf(stderr, "Insufficient Memory!\n");
+        free(suite.nodes);
+        free(suite.build);
+        free(suite.samples);
+        return 1;
+    }
+
+    if (format == SUITE_CSV)
+        printf("workload,size,runs,samples,mean_ns,median_ns,p99_ns\n");
+    else
+        printf("[");
+
+    for (suite.size = min; suite.size <= max; suite.size *= 10) {
+        suite.ops = suite.size < SUITE_OPS ? suite.size : SUITE_OPS;
+        for (work = 0; work < sizeof(suite_works) / sizeof(*suite_works); ++work) {
+            suite.seed = 0x9e3779b97f4a7c15ULL;
+            for (run = 0; run < warmup + runs; ++run) {
+                /* warmup runs are measured into the same buffer, then discarded */
+                if (run <= warmup)
+                    suite.count = 0;
+                suite_works[work].run(&suite);
+            }
+            suite_report(&suite, suite_works[work].name, runs, format, &first);
+        }
+    }
+
+    if (format == SUITE_JSON)
+        printf("\n]\n");
+
+    free(suite.nodes);
+    free(suite.build);
+    free(suite.samples);
+
+    return 0;
+}
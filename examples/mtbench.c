@@ -0,0 +1,370 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap.h"
+#include "heap_inbox.h"
+#include "heap_shard.h"
+#include "heap_parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#define TEST_LEN    1000000
+#define TEST_THREAD 16
+#define TEST_SCAN   10
+#define TEST_BULK   10000000
+
+struct bench_node {
+    struct heap_node node;
+    unsigned int data;
+};
+
+struct bench_thread {
+    pthread_t thread;
+    struct heap_inbox *inbox;
+    struct bench_node *nodes;
+    unsigned int index;
+    unsigned int count;
+    unsigned int popped;
+    unsigned long long sum;
+};
+
+#define heap_to_bench(ptr) \
+    heap_entry_safe(ptr, struct bench_node, node)
+
+static long bench_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    struct bench_node *nodea = heap_to_bench(hpa);
+    struct bench_node *nodeb = heap_to_bench(hpb);
+    return nodea->data < nodeb->data ? -1 : 1;
+}
+
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct heap_inbox bench_inbox[TEST_THREAD];
+static struct bench_thread bench_thread[TEST_THREAD];
+static HEAP_ROOT(bench_root);
+static struct heap_shard *bench_shard[TEST_THREAD];
+static struct heap_shards bench_shards;
+static pthread_barrier_t bench_barrier;
+
+static double time_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *mutex_producer(void *pdata)
+{
+    struct bench_thread *bthread = pdata;
+    unsigned int count;
+
+    for (count = 0; count < bthread->count; ++count) {
+        pthread_mutex_lock(&bench_lock);
+        heap_insert(&bench_root, &bthread->nodes[count].node, bench_cmp);
+        pthread_mutex_unlock(&bench_lock);
+    }
+
+    return NULL;
+}
+
+static void *inbox_producer(void *pdata)
+{
+    struct bench_thread *bthread = pdata;
+    unsigned int count;
+
+    for (count = 0; count < bthread->count; ++count)
+        heap_inbox_push(bthread->inbox, &bthread->nodes[count].node);
+
+    return NULL;
+}
+
+static unsigned int mutex_consume(unsigned int threads)
+{
+    unsigned int popped = 0;
+
+    (void)threads;
+    pthread_mutex_lock(&bench_lock);
+    if (bench_root.node) {
+        heap_delete(&bench_root, bench_root.node, bench_cmp);
+        popped++;
+    }
+    pthread_mutex_unlock(&bench_lock);
+
+    return popped;
+}
+
+static unsigned int inbox_consume(unsigned int threads)
+{
+    unsigned int count;
+
+    for (count = 0; count < threads; ++count)
+        heap_inbox_drain(&bench_inbox[count], &bench_root, bench_cmp);
+
+    if (!bench_root.node)
+        return 0;
+
+    heap_delete(&bench_root, bench_root.node, bench_cmp);
+    return 1;
+}
+
+static void bench_run(const char *name, struct bench_node *nodes, unsigned int threads,
+                      void *(*producer)(void *), unsigned int (*consume)(unsigned int))
+{
+    unsigned int count, popped;
+    double start, stop;
+
+    for (count = 0; count < threads; ++count) {
+        bench_thread[count].inbox = &bench_inbox[count];
+        bench_thread[count].nodes = nodes + TEST_LEN / threads * count;
+        bench_thread[count].count = TEST_LEN / threads;
+    }
+
+    start = time_now();
+    for (count = 0; count < threads; ++count)
+        pthread_create(&bench_thread[count].thread, NULL, producer, &bench_thread[count]);
+
+    for (popped = 0; popped < TEST_LEN / threads * threads;)
+        popped += consume(threads);
+
+    for (count = 0; count < threads; ++count)
+        pthread_join(bench_thread[count].thread, NULL);
+    stop = time_now();
+
+    printf("  %-6s %2u producers: %lf Mops/s\n", name, threads,
+           2.0 * popped / (stop - start) / 1e6);
+}
+
+static void *mutex_worker(void *pdata)
+{
+    struct bench_thread *bthread = pdata;
+    unsigned int count;
+
+    for (count = 0; count < bthread->count; ++count) {
+        pthread_mutex_lock(&bench_lock);
+        heap_insert(&bench_root, &bthread->nodes[count].node, bench_cmp);
+        if (count & 1) {
+            heap_delete(&bench_root, bench_root.node, bench_cmp);
+            bthread->popped++;
+        }
+        pthread_mutex_unlock(&bench_lock);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&bench_lock);
+        if (!bench_root.node) {
+            pthread_mutex_unlock(&bench_lock);
+            break;
+        }
+        heap_delete(&bench_root, bench_root.node, bench_cmp);
+        pthread_mutex_unlock(&bench_lock);
+        bthread->popped++;
+    }
+
+    return NULL;
+}
+
+static void *shard_worker(void *pdata)
+{
+    struct bench_thread *bthread = pdata;
+    struct heap_shard *shard;
+    unsigned int count;
+
+    /* first touch from the owning thread keeps the shard node-local */
+    shard = aligned_alloc(HEAP_SHARD_ALIGN, sizeof(*shard));
+    heap_shard_init(shard, bthread->index);
+    bench_shard[bthread->index] = shard;
+    pthread_barrier_wait(&bench_barrier);
+
+    for (count = 0; count < bthread->count; ++count) {
+        heap_shard_push(&bench_shards, bthread->index, &bthread->nodes[count].node, bench_cmp);
+        if ((count & 1) && heap_shard_pop(&bench_shards, bthread->index, bench_cmp))
+            bthread->popped++;
+    }
+
+    while (heap_shard_pop(&bench_shards, bthread->index, bench_cmp))
+        bthread->popped++;
+
+    pthread_barrier_wait(&bench_barrier);
+    return NULL;
+}
+
+static void bench_mixed(const char *name, struct bench_node *nodes,
+                        unsigned int threads, void *(*worker)(void *))
+{
+    unsigned int count, popped = 0;
+    double start, stop;
+
+    bench_shards = HEAP_SHARDS_INIT(bench_shard, threads);
+    pthread_barrier_init(&bench_barrier, NULL, threads);
+
+    for (count = 0; count < threads; ++count) {
+        bench_thread[count].nodes = nodes + TEST_LEN / threads * count;
+        bench_thread[count].index = count;
+        bench_thread[count].count = TEST_LEN / threads;
+        bench_thread[count].popped = 0;
+    }
+
+    start = time_now();
+    for (count = 0; count < threads; ++count)
+        pthread_create(&bench_thread[count].thread, NULL, worker, &bench_thread[count]);
+    for (count = 0; count < threads; ++count) {
+        pthread_join(bench_thread[count].thread, NULL);
+        popped += bench_thread[count].popped;
+    }
+    stop = time_now();
+
+    for (count = 0; count < threads; ++count) {
+        free(bench_shard[count]);
+        bench_shard[count] = NULL;
+    }
+    pthread_barrier_destroy(&bench_barrier);
+
+    printf("  %-6s %2u threads: %lf Mops/s\n", name, threads,
+           (TEST_LEN / threads * threads + popped) / (stop - start) / 1e6);
+}
+
+static void *scan_worker(void *pdata)
+{
+    struct bench_thread *bthread = pdata;
+    unsigned long start, end, index;
+    struct bench_node *bnode;
+    unsigned int pass;
+
+    start = (unsigned long)bench_root.count * bthread->index / bthread->count;
+    end = (unsigned long)bench_root.count * (bthread->index + 1) / bthread->count;
+
+    for (pass = 0; pass < TEST_SCAN; ++pass)
+        heap_for_each_entry_range(bnode, &index, &bench_root, start, end, node)
+            bthread->sum += bnode->data;
+
+    return NULL;
+}
+
+static void bench_scan(unsigned int threads)
+{
+    unsigned long long sum = 0;
+    unsigned int count;
+    double start, stop;
+
+    for (count = 0; count < threads; ++count) {
+        bench_thread[count].index = count;
+        bench_thread[count].count = threads;
+        bench_thread[count].sum = 0;
+    }
+
+    start = time_now();
+    for (count = 0; count < threads; ++count)
+        pthread_create(&bench_thread[count].thread, NULL, scan_worker, &bench_thread[count]);
+    for (count = 0; count < threads; ++count) {
+        pthread_join(bench_thread[count].thread, NULL);
+        sum += bench_thread[count].sum;
+    }
+    stop = time_now();
+
+    printf("  range  %2u threads: %lf Mnodes/s (sum %llx)\n", threads,
+           (double)bench_root.count * TEST_SCAN / (stop - start) / 1e6, sum);
+}
+
+static void bulk_scan(struct heap_node *hpnode, unsigned int worker, void *pdata)
+{
+    bench_thread[worker].sum += heap_to_bench(hpnode)->data;
+}
+
+static void bulk_release(struct heap_node *hpnode, void *pdata)
+{
+    hpnode->parent = hpnode->left = hpnode->right = NULL;
+}
+
+static int bench_bulk(void)
+{
+    struct bench_node *nodes;
+    struct heap_node **build;
+    unsigned int count, threads;
+    double start, build_time, scan_time;
+
+    nodes = malloc(TEST_BULK * sizeof(*nodes));
+    build = malloc(TEST_BULK * sizeof(*build));
+    if (!nodes || !build) {
+        printf("Insufficient Memory!\n");
+        free(nodes);
+        free(build);
+        return 1;
+    }
+
+    printf("Parallel Build, Scan and Destroy (%u nodes):\n", TEST_BULK);
+    for (threads = 1; threads <= TEST_THREAD; threads <<= 1) {
+        for (count = 0; count < TEST_BULK; ++count) {
+            nodes[count].data = rand();
+            build[count] = &nodes[count].node;
+        }
+        for (count = 0; count < threads; ++count)
+            bench_thread[count].sum = 0;
+
+        start = time_now();
+        heap_build_parallel(&bench_root, build, TEST_BULK, bench_cmp, threads);
+        build_time = time_now() - start;
+
+        start = time_now();
+        heap_scan_parallel(&bench_root, bulk_scan, NULL, threads);
+        scan_time = time_now() - start;
+
+        start = time_now();
+        heap_destroy_parallel(&bench_root, bulk_release, NULL, threads);
+        printf("  %2u threads: build %lf s, scan %lf s, destroy %lf s\n", threads,
+               build_time, scan_time, time_now() - start);
+    }
+
+    free(nodes);
+    free(build);
+    return 0;
+}
+
+int main(void)
+{
+    struct bench_node *nodes;
+    unsigned int count;
+
+    nodes = malloc(TEST_LEN * sizeof(*nodes));
+    if (!nodes) {
+        printf("Insufficient Memory!\n");
+        return 1;
+    }
+
+    for (count = 0; count < TEST_LEN; ++count)
+        nodes[count].data = rand();
+
+    for (count = 0; count < TEST_THREAD; ++count)
+        bench_inbox[count] = HEAP_INBOX_INIT;
+
+    printf("Multi-producer Insert and Pop (%u nodes):\n", TEST_LEN);
+    for (count = 1; count <= TEST_THREAD; count <<= 1) {
+        bench_run("mutex", nodes, count, mutex_producer, mutex_consume);
+        bench_run("inbox", nodes, count, inbox_producer, inbox_consume);
+    }
+
+    printf("Multi-thread Push and Pop (%u nodes):\n", TEST_LEN);
+    for (count = 1; count <= TEST_THREAD; count <<= 1) {
+        bench_mixed("mutex", nodes, count, mutex_worker);
+        bench_mixed("shard", nodes, count, shard_worker);
+    }
+
+    printf("Multi-thread Level Order Scan (%u nodes):\n", TEST_LEN);
+    for (count = 0; count < TEST_LEN; ++count)
+        heap_insert(&bench_root, &nodes[count].node, bench_cmp);
+    for (count = 1; count <= TEST_THREAD; count <<= 1)
+        bench_scan(count);
+    heap_clear(&bench_root);
+
+    if (bench_bulk()) {
+        free(nodes);
+        return 1;
+    }
+
+    free(nodes);
+    return 0;
+}
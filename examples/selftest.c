@@ -4,7 +4,18 @@
  */
 
 #include "heap.h"
+#include "heap_array.h"
+#include "heap_pairing.h"
+#include "heap_inbox.h"
+#include "heap_timer.h"
+#include "heap_shard.h"
+#include "heap_pool.h"
+#include "heap_merge.h"
+#include "heap_minmax.h"
+#include "heap_snap.h"
+#include "heap_parallel.h"
 #include <errno.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -77,7 +88,7 @@ static int heap_test_testing(struct heap_test_pdata *hdata)
 
     node = tnode;
     index = tindex;
-    heap_for_each_entry_from(node, &count, &heap_root, node) {
+    heap_for_each_entry_from(node, &index, &heap_root, node) {
         printf("heap 'heap_for_each_entry_from' test: %u\n", node->num);
     }
 
@@ -90,6 +101,1283 @@ static int heap_test_testing(struct heap_test_pdata *hdata)
     return 0;
 }
 
+static int heap_range_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node, *walk[TEST_LOOP];
+    unsigned long count, part, index;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    count = 0;
+    heap_for_each_entry(node, &index, &heap_root, node) {
+        if (index != count)
+            return -EFAULT;
+        walk[count++] = node;
+    }
+
+    if (count != TEST_LOOP)
+        return -EFAULT;
+
+    /* descending from the root reaches the same nodes */
+    node = heap_first_entry(&heap_root, &index, struct heap_test_node, node);
+    for (count = 0; node; ++count) {
+        if (index != count || walk[count] != node)
+            return -EFAULT;
+        node = heap_next_entry(&heap_root, &index, struct heap_test_node, node);
+    }
+
+    if (count != TEST_LOOP || heap_level_next(&heap_root, &index))
+        return -EFAULT;
+
+    /* three slices cover the walk exactly once */
+    for (count = part = 0; part < 3; ++part) {
+        heap_for_each_entry_range(node, &index, &heap_root, TEST_LOOP * part / 3,
+                                  TEST_LOOP * (part + 1) / 3, node) {
+            printf("heap 'heap_for_each_entry_range' test: %lu %u\n", part, node->num);
+            if (index != count || walk[count++] != node)
+                return -EFAULT;
+        }
+    }
+
+    if (count != TEST_LOOP)
+        return -EFAULT;
+
+    return 0;
+}
+
+static bool heap_test_leaf(struct heap_root_cached *cached)
+{
+    /* heap_find() counts from one, an empty heap has no last leaf */
+    if (!cached->root.count)
+        return !HEAP_CACHED_LEAF(cached);
+    return HEAP_CACHED_LEAF(cached) == heap_find(&cached->root, cached->root.count);
+}
+
+static int heap_cached_testing(struct heap_test_pdata *hdata)
+{
+    unsigned short saved[TEST_LOOP], last = 0;
+    struct heap_test_node *node;
+    unsigned int count;
+
+    HEAP_CACHED_ROOT(cached);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        heap_cached_insert(&cached, &hdata->nodes[count].node, heap_test_cmp);
+        if (!heap_test_leaf(&cached))
+            return -EFAULT;
+    }
+
+    /* raised keys sink into the last slot and move the cached leaf */
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = hpnode_to_test(cached.root.node);
+        saved[count] = node->num;
+        node->num = USHRT_MAX - count;
+        heap_cached_update(&cached, &node->node, heap_test_cmp);
+        if (!heap_test_leaf(&cached))
+            return -EFAULT;
+
+        heap_cached_delete(&cached, &node->node, heap_test_cmp);
+        heap_cached_insert(&cached, &node->node, heap_test_cmp);
+        if (!heap_test_leaf(&cached))
+            return -EFAULT;
+
+        node->num = saved[count];
+        heap_cached_fixup(&cached, &node->node, heap_test_cmp);
+        if (!heap_test_leaf(&cached))
+            return -EFAULT;
+    }
+
+    for (count = 0; count < TEST_LOOP; count += 3) {
+        printf("heap 'heap_cached_delete' test: %u\n", hdata->nodes[count].num);
+        heap_cached_delete(&cached, &hdata->nodes[count].node, heap_test_cmp);
+        if (!heap_test_leaf(&cached))
+            return -EFAULT;
+    }
+
+    while (cached.root.count) {
+        node = hpnode_to_test(cached.root.node);
+        printf("heap 'heap_cached_delete' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        heap_cached_delete(&cached, &node->node, heap_test_cmp);
+        if (!heap_test_leaf(&cached))
+            return -EFAULT;
+    }
+
+    return 0;
+}
+
+static int heap_build_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_node *nodes[TEST_LOOP];
+    struct heap_test_node *node;
+    unsigned short last = 0;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        nodes[count] = &hdata->nodes[count].node;
+    heap_build(&heap_root, nodes, TEST_LOOP, heap_test_cmp);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = hpnode_to_test(heap_root.node);
+        printf("heap 'heap_build' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        heap_delete(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    return 0;
+}
+
+static int heap_batch_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_node *nodes[TEST_LOOP];
+    struct heap_test_node *node;
+    unsigned short last = 0;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        nodes[count] = &hdata->nodes[count].node;
+
+    heap_insert_batch(&heap_root, nodes, 3, heap_test_cmp);
+    heap_insert_batch(&heap_root, nodes + 3, TEST_LOOP - 3, heap_test_cmp);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = hpnode_to_test(heap_root.node);
+        printf("heap 'heap_insert_batch' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        heap_delete(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    return 0;
+}
+
+/*
+ * Into 1023 nodes, a batch of one sifts up, a batch of two has both
+ * bounds equal at 20 and still sifts up, three take the bottom-up pass.
+ */
+#define TEST_BATCH_BASE 1023
+#define TEST_BATCH_MAX 3
+
+static int heap_batch_large_testing(void)
+{
+    struct heap_node *nodes[TEST_BATCH_BASE + TEST_BATCH_MAX], *hpnode;
+    struct heap_test_node *bnodes;
+    unsigned int count, batch;
+    unsigned long index;
+    int retval = 0;
+
+    HEAP_ROOT(heap_root);
+
+    bnodes = malloc(sizeof(*bnodes) * (TEST_BATCH_BASE + TEST_BATCH_MAX));
+    if (!bnodes)
+        return -ENOMEM;
+
+    for (batch = 1; !retval && batch <= TEST_BATCH_MAX; ++batch) {
+        /* the batch carries the smallest keys so it has to climb */
+        for (count = 0; count < TEST_BATCH_BASE + batch; ++count) {
+            if (count < TEST_BATCH_BASE)
+                bnodes[count].num = rand() % (USHRT_MAX - batch) + batch;
+            else
+                bnodes[count].num = count - TEST_BATCH_BASE;
+            nodes[count] = &bnodes[count].node;
+        }
+
+        heap_root = HEAP_INIT;
+        heap_build(&heap_root, nodes, TEST_BATCH_BASE, heap_test_cmp);
+        heap_insert_batch(&heap_root, nodes + TEST_BATCH_BASE, batch, heap_test_cmp);
+
+        count = 0;
+        heap_for_each(hpnode, &index, &heap_root) {
+            if (hpnode->parent && heap_test_cmp(hpnode, hpnode->parent) < 0)
+                retval = -EFAULT;
+            count++;
+        }
+
+        printf("heap 'heap_insert_batch' large test: %u\n", batch);
+        if (count != TEST_BATCH_BASE + batch || heap_root.count != count ||
+            hpnode_to_test(heap_root.node)->num)
+            retval = -EFAULT;
+
+#ifdef HEAP_STATS
+        /* one sift-up per node below the threshold, none past it */
+        if (heap_root.stats.fixups != (batch < TEST_BATCH_MAX ? batch : 0))
+            retval = -EFAULT;
+#endif
+    }
+
+    free(bnodes);
+    return retval;
+}
+
+static bool heap_test_pred(const struct heap_node *hpnode, void *pdata)
+{
+    return hpnode_to_test(hpnode)->num < *(unsigned short *)pdata;
+}
+
+static int heap_pop_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_node *nodes[TEST_LOOP];
+    struct heap_test_node *node;
+    unsigned short last = 0, limit = USHRT_MAX / 2;
+    unsigned int count, index, popped;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        nodes[count] = &hdata->nodes[count].node;
+    heap_build(&heap_root, nodes, TEST_LOOP, heap_test_cmp);
+
+    popped = heap_pop_batch(&heap_root, nodes, TEST_LOOP / 2, heap_test_cmp);
+    count = heap_pop_while(&heap_root, nodes + popped, TEST_LOOP - popped,
+                           heap_test_pred, &limit, heap_test_cmp);
+    popped += count;
+    popped += heap_pop_batch(&heap_root, nodes + popped, TEST_LOOP, heap_test_cmp);
+
+    if (popped != TEST_LOOP || heap_root.count)
+        return -EFAULT;
+
+    for (index = 0; index < popped; ++index) {
+        node = hpnode_to_test(nodes[index]);
+        printf("heap 'heap_pop_batch' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+    }
+
+    return 0;
+}
+
+static int heap_replace_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node, spare;
+    struct heap_node *hpnode;
+    unsigned short last = 0;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    spare.num = 0;
+    if (heap_pushpop(&heap_root, &spare.node, heap_test_cmp) != &spare.node)
+        return -EFAULT;
+
+    spare.num = USHRT_MAX;
+    hpnode = heap_pushpop(&heap_root, &spare.node, heap_test_cmp);
+    printf("heap 'heap_pushpop' test: %u\n", hpnode_to_test(hpnode)->num);
+
+    heap_replace(&heap_root, &spare.node, hpnode, heap_test_cmp);
+    if (heap_root.node != hpnode)
+        return -EFAULT;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = hpnode_to_test(heap_root.node);
+        printf("heap 'heap_replace' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        heap_delete(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    return 0;
+}
+
+static int heap_update_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node;
+    unsigned short last = 0;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    node = &hdata->nodes[TEST_LOOP / 2];
+    node->num /= 2;
+    heap_decrease_key(&heap_root, &node->node, heap_test_cmp);
+
+    node = hpnode_to_test(heap_root.node);
+    node->num += USHRT_MAX - node->num;
+    heap_increase_key(&heap_root, &node->node, heap_test_cmp);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = &hdata->nodes[count];
+        node->num ^= 0x5a5a;
+        heap_update(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = hpnode_to_test(heap_root.node);
+        printf("heap 'heap_update' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        heap_delete(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    return 0;
+}
+
+static int heap_pairing_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node;
+    struct heap_node *hpnode;
+    unsigned short last = 0;
+    unsigned int count;
+
+    HEAP_PAIRING(pairing);
+    HEAP_PAIRING(shard);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_pairing_insert(count & 1 ? &shard : &pairing,
+                            &hdata->nodes[count].node, heap_test_cmp);
+
+    node = &hdata->nodes[TEST_LOOP - 1];
+    node->num /= 2;
+    heap_pairing_fixup(&shard, &node->node, heap_test_cmp);
+
+    heap_pairing_meld(&pairing, &shard, heap_test_cmp);
+    if (pairing.count != TEST_LOOP || !HEAP_PAIRING_EMPTY(&shard))
+        return -EFAULT;
+
+    node = &hdata->nodes[TEST_LOOP / 2];
+    printf("heap 'heap_pairing_delete' test: %u\n", node->num);
+    heap_pairing_delete(&pairing, &node->node, heap_test_cmp);
+
+    while ((hpnode = heap_pairing_pop(&pairing, heap_test_cmp))) {
+        node = hpnode_to_test(hpnode);
+        printf("heap 'heap_pairing_pop' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+    }
+
+    return 0;
+}
+
+static uint64_t heap_test_key(const struct heap_node *hpnode)
+{
+    return hpnode_to_test(hpnode)->num;
+}
+
+static int heap_shard_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_shard local, remote, *shards[2] = {&local, &remote};
+    struct heap_test_node *node;
+    struct heap_node *hpnode;
+    unsigned int count, last = 0;
+
+    HEAP_SHARDS(set, shards, 2);
+    heap_shard_init(&local, 0);
+    heap_shard_init(&remote, 1);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_shard_push(&set, count & 1, &hdata->nodes[count].node, heap_test_cmp);
+
+    for (count = 0; (hpnode = heap_shard_pop(&set, 0, heap_test_cmp)); ++count) {
+        node = hpnode_to_test(hpnode);
+        printf("heap 'heap_shard_pop' test: %u\n", node->num);
+    }
+
+    if (count != TEST_LOOP || local.root.node || remote.root.node)
+        return -EFAULT;
+
+    /* a healthy local shard is popped first, the remote is left alone */
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_shard_push(&set, count & 1, &hdata->nodes[count].node, heap_test_cmp);
+    for (count = 0; count < TEST_LOOP / 2; ++count) {
+        node = hpnode_to_test(heap_shard_pop(&set, 0, heap_test_cmp));
+        if ((node - hdata->nodes) & 1)
+            return -EFAULT;
+    }
+    while (heap_shard_pop(&set, 0, heap_test_cmp))
+        ;
+
+    /* a published remote key better than local by more than slack is stolen */
+    set = HEAP_SHARDS_KEYED_INIT(shards, 2, heap_test_key, 0);
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_shard_push(&set, count & 1, &hdata->nodes[count].node, heap_test_cmp);
+    for (count = 0; (hpnode = heap_shard_pop(&set, 0, heap_test_cmp)); ++count) {
+        node = hpnode_to_test(hpnode);
+        printf("heap 'heap_shard_pop' keyed test: %u\n", node->num);
+        /* with no slack two shards drain in global order */
+        if (count && node->num < last)
+            return -EFAULT;
+        last = node->num;
+    }
+
+    if (count != TEST_LOOP || local.hint != HEAP_SHARD_EMPTY || remote.hint != HEAP_SHARD_EMPTY)
+        return -EFAULT;
+
+    return 0;
+}
+
+static void heap_test_destroy(struct heap_node *hpnode, void *pdata)
+{
+    unsigned int *count = pdata;
+
+    hpnode->parent = POISON_HPNODE3;
+    (*count)++;
+}
+
+static int heap_bounded_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_node *nodes[TEST_LOOP / 2], *evict;
+    struct heap_test_node *node;
+    unsigned int count, found, greater;
+
+    HEAP_BOUNDED_ROOT(bounded, TEST_LOOP / 2);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        evict = heap_offer(&bounded, &hdata->nodes[count].node, heap_test_cmp);
+        if (count < TEST_LOOP / 2 ? !!evict : !evict)
+            return -EFAULT;
+    }
+
+    if (heap_bounded_extract(&bounded, nodes, heap_test_cmp) != TEST_LOOP / 2 ||
+        bounded.root.node)
+        return -EFAULT;
+
+    for (count = 0; count < TEST_LOOP / 2; ++count) {
+        node = hpnode_to_test(nodes[count]);
+        printf("heap 'heap_bounded_extract' test: %u\n", node->num);
+        if (count && node->num > hpnode_to_test(nodes[count - 1])->num)
+            return -EFAULT;
+
+        /* only the nodes kept before it may be greater */
+        for (found = greater = 0; found < TEST_LOOP; ++found)
+            if (hdata->nodes[found].num > node->num)
+                greater++;
+        if (greater > count)
+            return -EFAULT;
+    }
+
+    return 0;
+}
+
+static int heap_minmax_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node, *min = NULL, *max = NULL;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_minmax_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        if (count & 1) {
+            node = hpnode_to_test(heap_minmax_peek_max(&heap_root, heap_test_cmp));
+            if (&node->node != heap_minmax_pop_max(&heap_root, heap_test_cmp))
+                return -EFAULT;
+            printf("heap 'heap_minmax_pop_max' test: %u\n", node->num);
+            if (max && node->num > max->num)
+                return -EFAULT;
+            max = node;
+        } else {
+            node = hpnode_to_test(heap_minmax_peek_min(&heap_root));
+            if (&node->node != heap_minmax_pop_min(&heap_root, heap_test_cmp))
+                return -EFAULT;
+            printf("heap 'heap_minmax_pop_min' test: %u\n", node->num);
+            if (min && node->num < min->num)
+                return -EFAULT;
+            min = node;
+        }
+        if (max && min->num > max->num)
+            return -EFAULT;
+    }
+
+    if (heap_root.node || heap_root.count)
+        return -EFAULT;
+
+    return 0;
+}
+
+static void heap_test_save(const struct heap_node *hpnode, struct heap_snap_record *record, void *pdata)
+{
+    struct heap_test_pdata *hdata = pdata;
+    struct heap_test_node *node = hpnode_to_test(hpnode);
+
+    record->key = node->num;
+    record->id = node - hdata->nodes;
+}
+
+static struct heap_node *heap_test_load(const struct heap_snap_record *record, void *pdata)
+{
+    struct heap_test_pdata *hdata = pdata;
+    struct heap_test_node *node = &hdata->nodes[record->id];
+
+    node->num = record->key;
+    return &node->node;
+}
+
+static int heap_snap_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_pdata *sdata;
+    struct heap_test_node *node, *snode;
+    unsigned int count;
+    FILE *file;
+    int retval = -EFAULT;
+
+    HEAP_ROOT(heap_root);
+    HEAP_ROOT(snap_root);
+
+    sdata = malloc(sizeof(*sdata));
+    if (!sdata)
+        return -ENOMEM;
+
+    if (!(file = tmpfile())) {
+        free(sdata);
+        return -errno;
+    }
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    if (heap_snap_save(&heap_root, fileno(file), heap_test_save, hdata) ||
+        heap_snap_load(&snap_root, fileno(file), heap_test_load, sdata) ||
+        snap_root.count != TEST_LOOP)
+        goto finish;
+
+    while (heap_root.node) {
+        node = hpnode_to_test(heap_root.node);
+        snode = hpnode_to_test(snap_root.node);
+        printf("heap 'heap_snap_load' test: %u\n", snode->num);
+        if (node->num != snode->num || node - hdata->nodes != snode - sdata->nodes)
+            goto finish;
+        heap_delete(&heap_root, &node->node, heap_test_cmp);
+        heap_delete(&snap_root, &snode->node, heap_test_cmp);
+    }
+
+    if (!snap_root.node)
+        retval = 0;
+
+finish:
+    fclose(file);
+    free(sdata);
+    return retval;
+}
+
+static int heap_destroy_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node, *tnode;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    count = 0;
+    heap_for_each_entry_safe(node, tnode, &heap_root, node) {
+        printf("heap 'heap_for_each_entry_safe' test: %u\n", node->num);
+        /* children are visited and dropped before their parent */
+        if ((node->node.left && node->node.left->parent != POISON_HPNODE3) ||
+            (node->node.right && node->node.right->parent != POISON_HPNODE3))
+            return -EFAULT;
+        node->node.parent = POISON_HPNODE3;
+        count++;
+    }
+
+    if (count != TEST_LOOP)
+        return -EFAULT;
+
+    heap_clear(&heap_root);
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_insert(&heap_root, &hdata->nodes[count].node, heap_test_cmp);
+
+    count = 0;
+    heap_destroy(&heap_root, heap_test_destroy, &count);
+    printf("heap 'heap_destroy' test: %u\n", count);
+    if (count != TEST_LOOP || heap_root.node || heap_root.count)
+        return -EFAULT;
+
+    return 0;
+}
+
+static int heap_pool_testing(void)
+{
+    struct heap_test_node *node, *nodes[HEAP_POOL_BATCH * 4];
+    struct heap_pool pool;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+    HEAP_POOL_CACHE(cache, &pool);
+    heap_pool_init(&pool, sizeof(*node));
+
+    for (count = 0; count < HEAP_POOL_BATCH * 4; ++count) {
+        if (!(node = nodes[count] = heap_pool_alloc(&cache)))
+            return -ENOMEM;
+        if ((uintptr_t)node % _Alignof(max_align_t))
+            return -EFAULT;
+        node->num = count;
+    }
+
+    for (count = 0; count < HEAP_POOL_BATCH * 4; ++count)
+        heap_pool_free(&cache, nodes[count]);
+
+    /* freed objects are handed out again before new slabs */
+    for (count = 0; count < HEAP_POOL_BATCH * 4; ++count) {
+        node = heap_pool_alloc(&cache);
+        if (!node || pool.slabs == NULL || *(void **)pool.slabs != NULL)
+            return -EFAULT;
+        node->num = TEST_LOOP - count % TEST_LOOP;
+        heap_insert(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    node = hpnode_to_test(heap_root.node);
+    printf("heap 'heap_pool' test: %u\n", node->num);
+    if (node->num != 1)
+        return -EFAULT;
+
+    heap_clear(&heap_root);
+    heap_pool_destroy(&pool);
+
+    /* a zero size still gets aligned objects that carry the free link */
+    heap_pool_init(&pool, 0);
+    cache = HEAP_POOL_CACHE_INIT(&pool);
+    if (!(nodes[0] = heap_pool_alloc(&cache)) || !(nodes[1] = heap_pool_alloc(&cache)) ||
+        nodes[0] == nodes[1] || (uintptr_t)nodes[1] % _Alignof(max_align_t))
+        return -EFAULT;
+    heap_pool_free(&cache, nodes[0]);
+    heap_pool_free(&cache, nodes[1]);
+    heap_pool_destroy(&pool);
+
+    return 0;
+}
+
+static bool heap_test_dead(const struct heap_node *hpnode, void *pdata)
+{
+    return hpnode_to_test(hpnode)->num & 1;
+}
+
+static void heap_test_release(struct heap_node *hpnode, void *pdata)
+{
+    printf("heap 'heap_lazy_cancel' test: %u\n", hpnode_to_test(hpnode)->num);
+    (*(unsigned int *)pdata)++;
+}
+
+static int heap_lazy_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node;
+    struct heap_node *hpnode;
+    unsigned int count, dead = 0, released = 0;
+    unsigned short last = 0;
+
+    HEAP_LAZY_ROOT(lazy, heap_test_dead, heap_test_release, &released);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_lazy_insert(&lazy, &hdata->nodes[count].node, heap_test_cmp);
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = &hdata->nodes[count];
+        if (heap_test_dead(&node->node, NULL)) {
+            heap_lazy_cancel(&lazy, &node->node, heap_test_cmp);
+            dead++;
+        }
+    }
+
+    if (HEAP_LAZY_LIVE(&lazy) != TEST_LOOP - dead)
+        return -EFAULT;
+
+    while ((hpnode = heap_lazy_pop(&lazy, heap_test_cmp))) {
+        node = hpnode_to_test(hpnode);
+        printf("heap 'heap_lazy_pop' test: %u\n", node->num);
+        if (node->num < last || heap_test_dead(hpnode, NULL))
+            return -EFAULT;
+        last = node->num;
+    }
+
+    if (released != dead || HEAP_LAZY_DEAD(&lazy))
+        return -EFAULT;
+
+    return 0;
+}
+
+#define TEST_LAZY 64
+
+static int heap_lazy_compact_testing(void)
+{
+    struct heap_test_node nodes[TEST_LAZY], *node;
+    struct heap_node *hpnode;
+    unsigned int count, dead, released = 0;
+    unsigned short last = 0;
+    unsigned long index;
+
+    HEAP_LAZY_ROOT(lazy, heap_test_dead, heap_test_release, &released);
+
+    /* distinct multiples of four, setting the dead bit keeps the order */
+    for (count = 0; count < TEST_LAZY; ++count) {
+        nodes[count].num = count * 37 % TEST_LAZY * 4;
+        heap_lazy_insert(&lazy, &nodes[count].node, heap_test_cmp);
+    }
+
+    /* cancel below the top until crossing the ratio compacts the heap */
+    for (count = dead = 0; count < TEST_LAZY && !released; ++count) {
+        node = &nodes[count];
+        if (&node->node == lazy.root.node)
+            continue;
+        node->num |= 1;
+        heap_lazy_cancel(&lazy, &node->node, heap_test_cmp);
+        dead++;
+    }
+
+    printf("heap 'heap_lazy_compact' test: %u\n", dead);
+    if (released != dead || dead * 100 <= TEST_LAZY * HEAP_LAZY_RATIO ||
+        HEAP_LAZY_DEAD(&lazy) || HEAP_LAZY_LIVE(&lazy) != TEST_LAZY - dead)
+        return -EFAULT;
+
+    count = 0;
+    heap_for_each(hpnode, &index, &lazy.root) {
+        if (heap_test_dead(hpnode, NULL) ||
+            (hpnode->parent && heap_test_cmp(hpnode, hpnode->parent) < 0))
+            return -EFAULT;
+        count++;
+    }
+
+    if (count != TEST_LAZY - dead)
+        return -EFAULT;
+
+    while ((hpnode = heap_lazy_pop(&lazy, heap_test_cmp))) {
+        node = hpnode_to_test(hpnode);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        count--;
+    }
+
+    return count ? -EFAULT : 0;
+}
+
+static int heap_inbox_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node;
+    unsigned short last = 0;
+    unsigned int count;
+
+    HEAP_ROOT(heap_root);
+    HEAP_INBOX(inbox);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        heap_inbox_push(&inbox, &hdata->nodes[count].node);
+
+    if (heap_inbox_drain(&inbox, &heap_root, heap_test_cmp) != TEST_LOOP)
+        return -EFAULT;
+
+    if (!HEAP_INBOX_EMPTY(&inbox) || heap_root.count != TEST_LOOP)
+        return -EFAULT;
+
+    for (count = 0; count < TEST_LOOP; ++count) {
+        node = hpnode_to_test(heap_root.node);
+        printf("heap 'heap_inbox_drain' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+        heap_delete(&heap_root, &node->node, heap_test_cmp);
+    }
+
+    return 0;
+}
+
+static int heap_timer_testing(void)
+{
+    struct heap_timer timers[TEST_LOOP], *timer;
+    struct heap_timer_base *base;
+    unsigned long now, last = 0;
+    unsigned int count, fired = 0;
+
+    base = malloc(sizeof(*base));
+    if (!base)
+        return -ENOMEM;
+
+    heap_timer_init(base, 0);
+    for (count = 0; count < TEST_LOOP; ++count) {
+        timers[count].expires = rand() % 100000;
+        heap_timer_add(base, &timers[count]);
+    }
+
+    heap_timer_cancel(base, &timers[TEST_LOOP / 2]);
+    if (HEAP_TIMER_COUNT(base) != TEST_LOOP - 1)
+        goto failed;
+
+    for (now = 0; now <= 100000; now += 100) {
+        while ((timer = heap_timer_expire(base, now))) {
+            printf("heap 'heap_timer_expire' test: %lu\n", timer->expires);
+            if (timer->expires > now || timer->expires < last)
+                goto failed;
+            last = timer->expires;
+            fired++;
+        }
+    }
+
+    free(base);
+    return fired == TEST_LOOP - 1 ? 0 : -EFAULT;
+
+failed:
+    free(base);
+    return -EFAULT;
+}
+
+#define TEST_TIMERS 1024
+#define TEST_TIMER_ROUND (HEAP_TIMER_SLOTS << HEAP_TIMER_SLOT_SHIFT)
+
+static int heap_timer_drain(struct heap_timer_base *base, struct heap_timer *timers,
+                            bool *pending, unsigned long now, unsigned int *fired)
+{
+    struct heap_timer *timer;
+    unsigned long last = 0;
+    unsigned int count;
+
+    while ((timer = heap_timer_expire(base, now))) {
+        if (timer->expires > now || timer->expires < last || !pending[timer - timers])
+            return -EFAULT;
+        pending[timer - timers] = false;
+        last = timer->expires;
+        (*fired)++;
+    }
+
+    /* every timer due by now has fired, wherever it was parked */
+    for (count = 0; count < TEST_TIMERS; ++count)
+        if (pending[count] && timers[count].expires <= now)
+            return -EFAULT;
+
+    return 0;
+}
+
+static int heap_timer_wheel_testing(void)
+{
+    struct heap_timer *timers;
+    struct heap_timer_base *base;
+    unsigned int count, armed = 0, fired = 0;
+    unsigned long start = 1000, now;
+    bool *pending;
+    int retval = -ENOMEM;
+
+    base = malloc(sizeof(*base));
+    timers = malloc(sizeof(*timers) * TEST_TIMERS);
+    pending = calloc(TEST_TIMERS, sizeof(*pending));
+    if (!base || !timers || !pending)
+        goto finish;
+
+    /* the next slot, one revolution, several rounds and far beyond */
+    heap_timer_init(base, start);
+    for (count = 0; count < TEST_TIMERS; ++count) {
+        switch (count % 4) {
+        case 0:
+            timers[count].expires = start + rand() % (1UL << HEAP_TIMER_SLOT_SHIFT);
+            break;
+        case 1:
+            timers[count].expires = start + rand() % TEST_TIMER_ROUND;
+            break;
+        case 2:
+            timers[count].expires = start + rand() % (TEST_TIMER_ROUND * 8);
+            break;
+        default:
+            timers[count].expires = start + TEST_TIMER_ROUND * 64 + rand() % TEST_TIMER_ROUND;
+            break;
+        }
+        heap_timer_add(base, &timers[count]);
+        pending[count] = true;
+        armed++;
+    }
+
+    retval = -EFAULT;
+    for (count = 0; count < TEST_TIMERS; count += 7) {
+        heap_timer_cancel(base, &timers[count]);
+        pending[count] = false;
+        armed--;
+    }
+
+    if (HEAP_TIMER_COUNT(base) != armed)
+        goto finish;
+
+    /* small steps across two revolutions */
+    for (now = start; now <= start + TEST_TIMER_ROUND * 2; now += 37)
+        if (heap_timer_drain(base, timers, pending, now, &fired))
+            goto finish;
+
+    /* jump several revolutions at once */
+    now = start + TEST_TIMER_ROUND * 6 + 123;
+    if (heap_timer_drain(base, timers, pending, now, &fired))
+        goto finish;
+
+    /* rearm the cancelled timers relative to the advanced clock */
+    for (count = 0; count < TEST_TIMERS; count += 7) {
+        timers[count].expires = now + rand() % (TEST_TIMER_ROUND * 3);
+        heap_timer_add(base, &timers[count]);
+        pending[count] = true;
+        armed++;
+    }
+
+    now = start + TEST_TIMER_ROUND * 66;
+    if (heap_timer_drain(base, timers, pending, now, &fired))
+        goto finish;
+
+    printf("heap 'heap_timer_expire' wheel test: %u\n", fired);
+    if (fired == armed && !HEAP_TIMER_COUNT(base))
+        retval = 0;
+
+finish:
+    free(pending);
+    free(timers);
+    free(base);
+    return retval;
+}
+
+static long heap_test_array_cmp(const void *nodea, const void *nodeb)
+{
+    const struct heap_test_node *tnodea = nodea;
+    const struct heap_test_node *tnodeb = nodeb;
+    return tnodea->num < tnodeb->num ? -1 : 1;
+}
+
+static int heap_array_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_test_node *node;
+    void *nodes[TEST_LOOP];
+    unsigned short last = 0;
+    unsigned int count, index;
+
+    HEAP_ARRAY(array, nodes, TEST_LOOP);
+
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_array_insert(&array, &hdata->nodes[count], heap_test_array_cmp))
+            return -EFAULT;
+
+    if (heap_array_insert(&array, &hdata->nodes[0], heap_test_array_cmp) != -ENOSPC)
+        return -EFAULT;
+
+    heap_array_for_each(node, index, &array)
+        printf("heap 'heap_array_for_each' test: %u\n", node->num);
+
+    while ((node = heap_array_pop(&array, heap_test_array_cmp))) {
+        printf("heap 'heap_array_pop' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+    }
+
+    return 0;
+}
+
+static int heap_dary_testing(struct heap_test_pdata *hdata)
+{
+    void *buffer[HEAP_DARY_SIZE(TEST_LOOP)] __attribute__((aligned(HEAP_DARY_ALIGN)));
+    struct heap_test_node *node;
+    struct heap_array dary;
+    unsigned short last = 0;
+    unsigned int count;
+
+    heap_dary_init(&dary, buffer, HEAP_DARY_SIZE(TEST_LOOP));
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_dary_insert(&dary, &hdata->nodes[count], heap_test_array_cmp))
+            return -EFAULT;
+
+    node = heap_dary_delete(&dary, TEST_LOOP / 2, heap_test_array_cmp);
+    printf("heap 'heap_dary_delete' test: %u\n", node->num);
+
+    while ((node = heap_dary_pop(&dary, heap_test_array_cmp))) {
+        printf("heap 'heap_dary_pop' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+    }
+
+    return 0;
+}
+
+static int heap_keyed_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_keyed_slot buffer[HEAP_KEYED_DARY_SIZE(TEST_LOOP)] __attribute__((aligned(HEAP_DARY_ALIGN)));
+    struct heap_keyed keyed, dary;
+    struct heap_test_node *node;
+    unsigned short last;
+    unsigned int count;
+
+    keyed = HEAP_KEYED_INIT(buffer, TEST_LOOP);
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_keyed_insert(&keyed, hdata->nodes[count].num, &hdata->nodes[count]))
+            return -EFAULT;
+
+    if (heap_keyed_insert(&keyed, 0, &hdata->nodes[0]) != -ENOSPC)
+        return -EFAULT;
+
+    keyed.slots[TEST_LOOP - 1].key = 0;
+    heap_keyed_erase(&keyed, TEST_LOOP - 1);
+    node = heap_keyed_pop(&keyed);
+    printf("heap 'heap_keyed_erase' test: %u\n", node->num);
+
+    for (last = 0; (node = heap_keyed_pop(&keyed)); last = node->num) {
+        printf("heap 'heap_keyed_pop' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+    }
+
+    heap_keyed_dary_init(&dary, buffer, HEAP_KEYED_DARY_SIZE(TEST_LOOP));
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_keyed_dary_insert(&dary, hdata->nodes[count].num, &hdata->nodes[count]))
+            return -EFAULT;
+
+    node = heap_keyed_dary_delete(&dary, TEST_LOOP / 2);
+    printf("heap 'heap_keyed_dary_delete' test: %u\n", node->num);
+
+    for (last = 0; (node = heap_keyed_dary_pop(&dary)); last = node->num) {
+        printf("heap 'heap_keyed_dary_pop' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+    }
+
+    return 0;
+}
+
+static int heap_stable_testing(struct heap_test_pdata *hdata)
+{
+    struct heap_keyed_slot buffer[HEAP_KEYED_DARY_SIZE(TEST_LOOP)] __attribute__((aligned(HEAP_DARY_ALIGN)));
+    struct heap_test_node *node, *last;
+    struct heap_keyed keyed, dary;
+    unsigned int count, done;
+
+    /* start next to the end of the sequence space to cross a rebase */
+    keyed = HEAP_KEYED_INIT(buffer, TEST_LOOP);
+    keyed.seq = HEAP_KEYED_SEQ_MASK - TEST_LOOP / 2;
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_keyed_stable_insert(&keyed, hdata->nodes[count].num & 1, &hdata->nodes[count]))
+            return -EFAULT;
+
+    for (last = NULL; (node = heap_keyed_pop(&keyed)); last = node) {
+        printf("heap 'heap_keyed_stable_insert' test: %u\n", node->num);
+        /* nodes were inserted in array order */
+        if (last && ((last->num & 1) > (node->num & 1) ||
+                     ((last->num & 1) == (node->num & 1) && last > node)))
+            return -EFAULT;
+    }
+
+    /* keep sequence 0 queued while cycling through several rebases */
+    keyed = HEAP_KEYED_INIT(buffer, TEST_LOOP);
+    if (heap_keyed_stable_insert(&keyed, 1, &hdata->nodes[0]))
+        return -EFAULT;
+    keyed.seq = HEAP_KEYED_SEQ_MASK - TEST_LOOP / 2;
+    for (count = 1, done = 0; count < TEST_LOOP * TEST_LOOP; ++count) {
+        if (heap_keyed_stable_insert(&keyed, 0, &hdata->nodes[count % (TEST_LOOP - 1) + 1]))
+            return -EFAULT;
+        if (count < TEST_LOOP / 2)
+            continue;
+        node = heap_keyed_pop(&keyed);
+        if (node != &hdata->nodes[++done % (TEST_LOOP - 1) + 1])
+            return -EFAULT;
+    }
+
+    while ((node = heap_keyed_pop(&keyed))) {
+        printf("heap 'heap_keyed_stable_insert' rebase test: %u\n", node->num);
+        if (node != (HEAP_KEYED_EMPTY(&keyed) ? &hdata->nodes[0] :
+                     &hdata->nodes[++done % (TEST_LOOP - 1) + 1]))
+            return -EFAULT;
+    }
+
+    heap_keyed_dary_init(&dary, buffer, HEAP_KEYED_DARY_SIZE(TEST_LOOP));
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_keyed_dary_stable_insert(&dary, hdata->nodes[count].num & 1, &hdata->nodes[count]))
+            return -EFAULT;
+
+    for (last = NULL; (node = heap_keyed_dary_pop(&dary)); last = node) {
+        printf("heap 'heap_keyed_dary_stable_insert' test: %u\n", node->num);
+        /* nodes were inserted in array order */
+        if (last && ((last->num & 1) > (node->num & 1) ||
+                     ((last->num & 1) == (node->num & 1) && last > node)))
+            return -EFAULT;
+    }
+
+    return 0;
+}
+
+static int heap_index_testing(struct heap_test_pdata *hdata)
+{
+    uint32_t slots[TEST_LOOP], where[TEST_LOOP], entry;
+    struct heap_test_node *node;
+    struct heap_index index;
+    unsigned short last = 0, save;
+    unsigned int count;
+
+    heap_index_init(&index, slots, where, TEST_LOOP, hdata->nodes, sizeof(*hdata->nodes));
+    for (count = 0; count < TEST_LOOP; ++count)
+        if (heap_index_insert(&index, count, heap_test_array_cmp))
+            return -EFAULT;
+
+    if (heap_index_insert(&index, 0, heap_test_array_cmp) != -ENOSPC)
+        return -EFAULT;
+
+    node = HEAP_INDEX_ENTRY(&index, TEST_LOOP - 1);
+    save = node->num;
+    node->num = 0;
+    heap_index_update(&index, TEST_LOOP - 1, heap_test_array_cmp);
+    if (heap_index_peek(&index) != TEST_LOOP - 1)
+        return -EFAULT;
+    node->num = save;
+    heap_index_update(&index, TEST_LOOP - 1, heap_test_array_cmp);
+
+    heap_index_delete(&index, TEST_LOOP / 2, heap_test_array_cmp);
+    printf("heap 'heap_index_delete' test: %u\n", hdata->nodes[TEST_LOOP / 2].num);
+    if (HEAP_INDEX_QUEUED(&index, TEST_LOOP / 2))
+        return -EFAULT;
+
+    while ((entry = heap_index_pop(&index, heap_test_array_cmp)) != HEAP_INDEX_NONE) {
+        node = HEAP_INDEX_ENTRY(&index, entry);
+        printf("heap 'heap_index_pop' test: %u\n", node->num);
+        if (node->num < last)
+            return -EFAULT;
+        last = node->num;
+    }
+
+    return 0;
+}
+
+struct heap_test_run {
+    struct heap_merge_cursor cursor;
+    const unsigned short *next;
+    unsigned int left;
+};
+
+static long heap_test_merge_cmp(const struct heap_node *hpa, const struct heap_node *hpb)
+{
+    const unsigned short *keya = HEAP_MERGE_RECORD(heap_to_cursor(hpa));
+    const unsigned short *keyb = HEAP_MERGE_RECORD(heap_to_cursor(hpb));
+    return *keya < *keyb ? -1 : 1;
+}
+
+static bool heap_test_refill(struct heap_merge_cursor *cursor)
+{
+    struct heap_test_run *run = heap_entry(cursor, struct heap_test_run, cursor);
+
+    if (!run->left)
+        return false;
+
+    /* hand out a single record per batch */
+    cursor->pos = (const char *)run->next;
+    cursor->end = (const char *)++run->next;
+    run->left--;
+
+    return true;
+}
+
+static int heap_merge_testing(void)
+{
+    static const unsigned short runa[] = {1, 4, 7, 10};
+    static const unsigned short runb[] = {2, 5, 8};
+    static const unsigned short runc[] = {0, 3, 6, 9, 11};
+    struct heap_merge_cursor cursora, cursorb, empty;
+    struct heap_test_run run;
+    const unsigned short *key;
+    unsigned int count;
+
+    HEAP_MERGE(merge, sizeof(*key));
+    heap_merge_buffer(&cursora, runa, sizeof(runa));
+    heap_merge_buffer(&cursorb, runb, sizeof(runb));
+    heap_merge_buffer(&empty, runa, 0);
+    run.cursor.pos = run.cursor.end = NULL;
+    run.cursor.refill = heap_test_refill;
+    run.next = runc;
+    run.left = sizeof(runc) / sizeof(*runc);
+
+    if (heap_merge_add(&merge, &cursora, heap_test_merge_cmp) ||
+        heap_merge_add(&merge, &cursorb, heap_test_merge_cmp) ||
+        heap_merge_add(&merge, &run.cursor, heap_test_merge_cmp) ||
+        heap_merge_add(&merge, &empty, heap_test_merge_cmp) != -ENODATA)
+        return -EFAULT;
+
+    for (count = 0; (key = heap_merge_next(&merge, heap_test_merge_cmp)); ++count) {
+        printf("heap 'heap_merge_next' test: %u\n", *key);
+        if (*key != count)
+            return -EFAULT;
+    }
+
+    if (count != 12 || !HEAP_MERGE_EMPTY(&merge))
+        return -EFAULT;
+
+    return 0;
+}
+
+#define TEST_PARALLEL_THREADS 4
+#define TEST_PARALLEL (HEAP_PARALLEL_MIN * TEST_PARALLEL_THREADS + 1)
+
+static void heap_test_scan(struct heap_node *hpnode, unsigned int worker, void *pdata)
+{
+    unsigned int *counts = pdata;
+
+    if (!hpnode->parent || heap_test_cmp(hpnode, hpnode->parent) > 0)
+        counts[worker]++;
+}
+
+static void heap_test_release_parallel(struct heap_node *hpnode, void *pdata)
+{
+    unsigned int *count = pdata;
+
+    hpnode->parent = POISON_HPNODE3;
+    __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+}
+
+static int heap_parallel_testing(void)
+{
+    unsigned int counts[TEST_PARALLEL_THREADS] = {}, count, total;
+    struct heap_test_node *nodes;
+    struct heap_node **build;
+    int retval = -EFAULT;
+
+    HEAP_ROOT(heap_root);
+
+    nodes = malloc(TEST_PARALLEL * sizeof(*nodes));
+    build = malloc(TEST_PARALLEL * sizeof(*build));
+    if (!nodes || !build) {
+        free(nodes);
+        free(build);
+        return -ENOMEM;
+    }
+
+    for (count = 0; count < TEST_PARALLEL; ++count) {
+        nodes[count].num = rand();
+        build[count] = &nodes[count].node;
+    }
+
+    heap_build_parallel(&heap_root, build, TEST_PARALLEL, heap_test_cmp, TEST_PARALLEL_THREADS);
+    if (heap_root.count != TEST_PARALLEL)
+        goto finish;
+
+    /* every node counted by some worker is in order with its parent */
+    heap_scan_parallel(&heap_root, heap_test_scan, counts, TEST_PARALLEL_THREADS);
+    for (count = total = 0; count < TEST_PARALLEL_THREADS; ++count) {
+        printf("heap 'heap_scan_parallel' test: worker %u: %u\n", count, counts[count]);
+        total += counts[count];
+    }
+    if (total != TEST_PARALLEL)
+        goto finish;
+
+    total = 0;
+    heap_destroy_parallel(&heap_root, heap_test_release_parallel, &total, TEST_PARALLEL_THREADS);
+    printf("heap 'heap_destroy_parallel' test: %u\n", total);
+    if (total != TEST_PARALLEL || heap_root.node)
+        goto finish;
+
+    retval = 0;
+
+finish:
+    free(nodes);
+    free(build);
+    return retval;
+}
+
 int main(void)
 {
     struct heap_test_pdata *rdata;
@@ -104,6 +1392,60 @@ int main(void)
         rdata->nodes[count].num = rand();
 
     retval = heap_test_testing(rdata);
+    if (!retval)
+        retval = heap_range_testing(rdata);
+    if (!retval)
+        retval = heap_cached_testing(rdata);
+    if (!retval)
+        retval = heap_build_testing(rdata);
+    if (!retval)
+        retval = heap_batch_testing(rdata);
+    if (!retval)
+        retval = heap_batch_large_testing();
+    if (!retval)
+        retval = heap_pop_testing(rdata);
+    if (!retval)
+        retval = heap_replace_testing(rdata);
+    if (!retval)
+        retval = heap_update_testing(rdata);
+    if (!retval)
+        retval = heap_lazy_testing(rdata);
+    if (!retval)
+        retval = heap_lazy_compact_testing();
+    if (!retval)
+        retval = heap_inbox_testing(rdata);
+    if (!retval)
+        retval = heap_timer_testing();
+    if (!retval)
+        retval = heap_timer_wheel_testing();
+    if (!retval)
+        retval = heap_array_testing(rdata);
+    if (!retval)
+        retval = heap_dary_testing(rdata);
+    if (!retval)
+        retval = heap_index_testing(rdata);
+    if (!retval)
+        retval = heap_keyed_testing(rdata);
+    if (!retval)
+        retval = heap_stable_testing(rdata);
+    if (!retval)
+        retval = heap_pairing_testing(rdata);
+    if (!retval)
+        retval = heap_shard_testing(rdata);
+    if (!retval)
+        retval = heap_destroy_testing(rdata);
+    if (!retval)
+        retval = heap_bounded_testing(rdata);
+    if (!retval)
+        retval = heap_minmax_testing(rdata);
+    if (!retval)
+        retval = heap_snap_testing(rdata);
+    if (!retval)
+        retval = heap_pool_testing();
+    if (!retval)
+        retval = heap_merge_testing();
+    if (!retval)
+        retval = heap_parallel_testing();
     free(rdata);
 
     return retval;
@@ -4,39 +4,6 @@
  */
 
 #include "heap.h"
-#include "titer.h"
-
-static __always_inline void
-parent_swap(struct heap_root *root, struct heap_node *parent, struct heap_node *node)
-{
-    struct heap_node *gparent = parent->parent;
-    struct heap_node shadow = *node;
-
-    if (node->left)
-        node->left->parent = parent;
-    if (node->right)
-        node->right->parent = parent;
-
-    if (parent->left == node) {
-        node->left = parent;
-        if ((node->right = parent->right))
-            parent->right->parent = node;
-    } else { /* parent->right == node */
-        node->right = parent;
-        if ((node->left = parent->left))
-            parent->left->parent = node;
-    }
-
-    if (!(node->parent = gparent))
-        root->node = node;
-    else if (gparent->left == parent)
-        gparent->left = node;
-    else /* gparent->right == parent */
-        gparent->right = node;
-
-    *parent = shadow;
-    parent->parent = node;
-}
 
 /**
  * heap_fixup - balance after insert node.
@@ -46,13 +13,18 @@ parent_swap(struct heap_root *root, struct heap_node *parent, struct heap_node *
  */
 void heap_fixup(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
 {
-    struct heap_node *parent;
+    heap_fixup_inline(root, node, cmp);
+}
 
-    while ((parent = node->parent)) {
-        if (cmp(node, parent) >= 0)
-            break;
-        parent_swap(root, parent, node);
-    }
+/**
+ * heap_fixdown - balance after node moves toward the bottom.
+ * @root: heap root of node.
+ * @node: node to sink.
+ * @cmp: operator defining the node order.
+ */
+void heap_fixdown(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    heap_fixdown_inline(root, node, cmp);
 }
 
 /**
@@ -63,44 +35,18 @@ void heap_fixup(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
  */
 void heap_erase(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
 {
-    struct heap_node *successor = node->parent;
-    struct heap_node *child1, *child2;
-    long result;
-
-    if (successor && (result = cmp(node, successor)) < 0)
-        heap_fixup(root, node, cmp);
-
-    else for (;;) {
-        child1 = node->left;
-        child2 = node->right;
-
-        if (!child1 && !child2)
-            return;
-        else if (!child2)
-            successor = node->left;
-        else if (!child1)
-            successor = node->left;
-        else { /* child1 && child2 */
-            if (cmp(node->left, node->right) < 0)
-                successor = node->left;
-            else
-                successor = node->right;
-        }
-
-        if (cmp(node, successor) < 0)
-            return;
-        parent_swap(root, node, successor);
-    }
+    heap_erase_inline(root, node, cmp);
 }
 
 /**
- * heap_remove - remove node form heap.
+ * heap_remove_last - remove node form heap with known last node.
  * @root: heap root of node.
  * @node: node to remove.
+ * @last: the last node in level order of @root.
  */
-struct heap_node *heap_remove(struct heap_root *root, struct heap_node *node)
+struct heap_node *heap_remove_last(struct heap_root *root, struct heap_node *node, struct heap_node *last)
 {
-    struct heap_node *successor = heap_find(root, root->count);
+    struct heap_node *successor = last;
 
     if (!successor->parent) {
         /*
@@ -173,6 +119,113 @@ finish:
     return successor;
 }
 
+/**
+ * heap_remove - remove node form heap.
+ * @root: heap root of node.
+ * @node: node to remove.
+ */
+struct heap_node *heap_remove(struct heap_root *root, struct heap_node *node)
+{
+    return heap_remove_last(root, node, heap_find(root, root->count));
+}
+
+/**
+ * heap_prev - find the previous node in level order.
+ * @root: heap tree want to search.
+ * @node: node at @index.
+ * @index: index of @node, must be greater than one.
+ */
+struct heap_node *heap_prev(const struct heap_root *root, struct heap_node *node, unsigned int index)
+{
+    unsigned int depth = 0;
+
+    /* climb while node is a left child */
+    while (index > 1 && !(index & 1)) {
+        node = node->parent;
+        index >>= 1;
+        depth++;
+    }
+
+    if (index == 1) {
+        /* leftmost of its level, wrap to the rightmost of the level above */
+        node = root->node;
+        depth--;
+    } else
+        node = node->parent->left;
+
+    while (depth--)
+        node = node->right;
+
+    return node;
+}
+
+/**
+ * heap_next - find the next node in level order.
+ * @root: heap tree want to search.
+ * @node: node at @index.
+ * @index: index of @node.
+ */
+struct heap_node *heap_next(const struct heap_root *root, struct heap_node *node, unsigned int index)
+{
+    unsigned int depth = 0;
+
+    /* climb while node is a right child */
+    while (index > 1 && (index & 1)) {
+        node = node->parent;
+        index >>= 1;
+        depth++;
+    }
+
+    if (index == 1) {
+        /* rightmost of its level, wrap to the leftmost of the level below */
+        node = root->node;
+        depth++;
+    } else
+        node = node->parent->right;
+
+    while (node && depth--)
+        node = node->left;
+
+    return node;
+}
+
+static __always_inline void
+node_transplant(struct heap_root *root, struct heap_node *old, struct heap_node *new)
+{
+    struct heap_node *parent = old->parent;
+
+    *new = *old;
+    if (old->left)
+        old->left->parent = new;
+    if (old->right)
+        old->right->parent = new;
+
+    if (!parent)
+        root->node = new;
+    else if (parent->left == old)
+        parent->left = new;
+    else /* parent->right == old */
+        parent->right = new;
+}
+
+/**
+ * heap_replace - replace node in heap and rebalance.
+ * @root: heap root of node.
+ * @old: node to be replaced.
+ * @new: new node to take the place of @old.
+ * @cmp: operator defining the node order.
+ */
+void heap_replace(struct heap_root *root, struct heap_node *old, struct heap_node *new, heap_cmp_t cmp)
+{
+    node_transplant(root, old, new);
+
+    old->left = POISON_HPNODE1;
+    old->right = POISON_HPNODE2;
+    old->parent = POISON_HPNODE3;
+
+    heap_erase_inline(root, new, cmp);
+}
+
 /**
  * heap_parent - find the parent node.
  * @root: heap tree want to search.
@@ -186,10 +239,9 @@ heap_parent(struct heap_root *root, struct heap_node **parentp, struct heap_node
     struct heap_node **link;
 
     link = &root->node;
-    if (unlikely(!*link)) {
-        *parentp = NULL;
+    *parentp = NULL;
+    if (unlikely(!*link))
         return link;
-    }
 
     while (depth--) {
         *parentp = *link;
@@ -202,18 +254,51 @@ heap_parent(struct heap_root *root, struct heap_node **parentp, struct heap_node
     return link;
 }
 
+/**
+ * heap_cached_parent - find the parent node from the cached leaf.
+ * @cached: cached heap tree want to search.
+ * @parentp: pointer used to modify the parent node pointer.
+ *
+ * The free slot follows the last leaf in level order, so it is either
+ * the leaf's right sibling or the left child of the node following the
+ * leaf's parent, which heap_next() reaches in amortised O(1) hops.
+ */
+struct heap_node **
+heap_cached_parent(struct heap_root_cached *cached, struct heap_node **parentp)
+{
+    struct heap_root *root = &cached->root;
+    struct heap_node *parent = cached->leaf;
+    unsigned int count = root->count;
+
+    *parentp = NULL;
+    if (unlikely(!count))
+        return &root->node;
+
+    if (count > 1) {
+        parent = parent->parent;
+        if (!(count & 1)) {
+            *parentp = parent;
+            return &parent->right;
+        }
+        parent = heap_next(root, parent, count >> 1);
+    }
+
+    *parentp = parent;
+    return &parent->left;
+}
+
 /**
  * heap_find - find @index in tree @root.
  * @root: heap tree want to search.
- * @index: index of node.
+ * @index: index of node, counting from one at the root.
  */
-struct heap_node *heap_find(struct heap_root *root, unsigned int index)
+struct heap_node *heap_find(const struct heap_root *root, unsigned int index)
 {
-    unsigned int depth = 63 - __builtin_clzll(root->count);
+    unsigned int depth = 63 - __builtin_clzll(index);
     struct heap_node *node = root->node;
 
     while (node && depth--) {
-        if ((root->count) & (1UL << depth))
+        if (index & (1UL << depth))
             node = node->right;
         else
             node = node->left;
@@ -222,4 +307,391 @@ struct heap_node *heap_find(struct heap_root *root, unsigned int index)
     return node;
 }
 
-TITER_LEVELORDER_DEFINE(, heap, struct heap_root, node, struct heap_node, left, right)
+/**
+ * heap_build - build heap from unordered nodes.
+ * @root: heap root to build, expected to be empty.
+ * @nodes: array of nodes to add, reordered in place.
+ * @count: number of @nodes.
+ * @cmp: operator defining the node order.
+ *
+ * The array is heapified bottom-up first and then linked into a complete
+ * tree in one pass, which costs O(n) instead of O(n log n) insertions.
+ */
+void heap_build(struct heap_root *root, struct heap_node **nodes, unsigned int count, heap_cmp_t cmp)
+{
+    unsigned int index;
+
+    if (unlikely(root->node)) {
+        for (index = 0; index < count; ++index)
+            heap_insert(root, nodes[index], cmp);
+        return;
+    }
+
+    for (index = count >> 1; index--;)
+        heap_build_siftdown(root, nodes, count, index, cmp);
+
+    heap_build_link(nodes, count, 0, count);
+    root->node = count ? nodes[0] : NULL;
+    root->count = count;
+    if (count)
+        heap_stats_depth(&root->stats, 64U - __builtin_clzll(count));
+}
+
+static void batch_heapify(struct heap_root *root, unsigned int lo, unsigned int hi, heap_cmp_t cmp)
+{
+    struct heap_node *node, *prev;
+    unsigned int index;
+
+    /*
+     * Sift down every position in [lo, hi] and then the ancestors of the
+     * range, highest index first. Sinking a node only disturbs its own
+     * subtree, so all positions still to be visited keep their nodes.
+     */
+    while (lo && lo <= hi) {
+        node = heap_find(root, hi);
+        for (index = hi;; --index) {
+            prev = index > lo ? heap_prev(root, node, index) : NULL;
+            heap_fixdown_inline(root, node, cmp);
+            if (!prev)
+                break;
+            node = prev;
+        }
+
+        index = hi >> 1;
+        hi = index < lo ? index : lo - 1;
+        lo >>= 1;
+    }
+}
+
+/**
+ * heap_insert_batch - insert an array of nodes at once.
+ * @root: heap root to insert.
+ * @nodes: array of new nodes.
+ * @count: number of @nodes.
+ * @cmp: operator defining the node order.
+ *
+ * All nodes are appended with one incremental walk over the parents of
+ * the new slots. Order is then restored either with one sift-up per node
+ * or with a single bottom-up pass over their ancestors, whichever bound
+ * is lower.
+ */
+void heap_insert_batch(struct heap_root *root, struct heap_node **nodes, unsigned int count, heap_cmp_t cmp)
+{
+    struct heap_node *parent = NULL, *node;
+    unsigned int base = root->count, index, pindex, lo, hi;
+    unsigned long bottom, batch;
+
+    if (!count)
+        return;
+
+    pindex = (base + 1) >> 1;
+    if (pindex)
+        parent = heap_find(root, pindex);
+
+    for (index = base + 1; index <= base + count; ++index) {
+        node = nodes[index - base - 1];
+        node->left = node->right = NULL;
+
+        if (unlikely(index == 1)) {
+            node->parent = NULL;
+            root->node = node;
+            continue;
+        }
+
+        if ((index >> 1) != pindex) {
+            pindex = index >> 1;
+            if (pindex <= base)
+                parent = heap_next(root, parent, pindex - 1);
+            else
+                parent = nodes[pindex - base - 1];
+        }
+
+        node->parent = parent;
+        if (index & 1)
+            parent->right = node;
+        else
+            parent->left = node;
+    }
+
+    root->count += count;
+
+    /* compare bound of sift-ups against the ancestors to sink */
+    lo = (base + 1) >> 1;
+    hi = root->count >> 1;
+    batch = (unsigned long)count * (31 - __builtin_clz(root->count));
+    for (bottom = 0; lo && lo <= hi; lo >>= 1, hi >>= 1)
+        bottom += (hi - lo + 1) << 1;
+
+    if (batch <= bottom) {
+        for (index = 0; index < count; ++index)
+            heap_fixup_inline(root, nodes[index], cmp);
+    } else
+        batch_heapify(root, ((base + 1) >> 1) ?: 1, root->count >> 1, cmp);
+}
+
+static struct heap_node *pop_top(struct heap_root *root, struct heap_node **lastp, heap_cmp_t cmp)
+{
+    struct heap_node *top = root->node, *last = *lastp;
+    struct heap_node *prev, *rebalance;
+
+    /* the slot before the current last one becomes the last */
+    prev = root->count > 1 ? heap_prev(root, last, root->count) : NULL;
+    if (prev == top)
+        prev = last;
+
+    if ((rebalance = heap_remove_last(root, top, last))) {
+        heap_fixdown_inline(root, rebalance, cmp);
+        /* a leaf that was swapped up now has children */
+        if (prev != rebalance && (prev->left || prev->right))
+            prev = rebalance;
+    }
+
+    top->left = POISON_HPNODE1;
+    top->right = POISON_HPNODE2;
+    top->parent = POISON_HPNODE3;
+
+    *lastp = prev;
+    return top;
+}
+
+/**
+ * heap_pop_batch - delete up to @count nodes from the top.
+ * @root: heap root to pop.
+ * @nodes: array receiving the nodes in order.
+ * @count: maximum number of nodes to pop.
+ * @cmp: operator defining the node order.
+ *
+ * The last node is located once and then tracked across pops, so each
+ * pop only pays for its sift-down. That sift-down is still a full one
+ * per node, popping k nodes costs O(k log n) like k heap_pop() calls,
+ * only the walks to the last node are saved. Returns the number of
+ * popped nodes.
+ */
+unsigned int heap_pop_batch(struct heap_root *root, struct heap_node **nodes, unsigned int count, heap_cmp_t cmp)
+{
+    struct heap_node *last;
+    unsigned int index;
+
+    if (!root->count)
+        return 0;
+
+    last = heap_find(root, root->count);
+    for (index = 0; index < count && root->node; ++index)
+        nodes[index] = pop_top(root, &last, cmp);
+
+    return index;
+}
+
+/**
+ * heap_bounded_extract - empty bounded heap into a sorted array.
+ * @bounded: bounded heap to extract.
+ * @nodes: array of at least @bounded->limit entries.
+ * @cmp: operator defining the node order.
+ *
+ * The nodes are stored best first, that is in the reverse of the pop
+ * order. Returns the number of extracted nodes.
+ */
+unsigned int heap_bounded_extract(struct heap_bounded *bounded, struct heap_node **nodes, heap_cmp_t cmp)
+{
+    struct heap_node *node;
+    unsigned int count, index;
+
+    count = heap_pop_batch(&bounded->root, nodes, bounded->root.count, cmp);
+    for (index = 0; index < count / 2; ++index) {
+        node = nodes[index];
+        nodes[index] = nodes[count - 1 - index];
+        nodes[count - 1 - index] = node;
+    }
+
+    return count;
+}
+
+/**
+ * heap_pop_while - delete nodes from the top while @pred holds.
+ * @root: heap root to pop.
+ * @nodes: array receiving the nodes in order.
+ * @count: maximum number of nodes to pop.
+ * @pred: predicate tested on the top node.
+ * @pdata: private data of @pred.
+ * @cmp: operator defining the node order.
+ *
+ * Returns the number of popped nodes.
+ */
+unsigned int heap_pop_while(struct heap_root *root, struct heap_node **nodes, unsigned int count,
+                            heap_pred_t pred, void *pdata, heap_cmp_t cmp)
+{
+    struct heap_node *last = NULL;
+    unsigned int index;
+
+    for (index = 0; index < count && root->node; ++index) {
+        if (!pred(root->node, pdata))
+            break;
+        if (!last)
+            last = heap_find(root, root->count);
+        nodes[index] = pop_top(root, &last, cmp);
+    }
+
+    return index;
+}
+
+static void lazy_release(struct heap_lazy *lazy, struct heap_node *node)
+{
+    node->left = POISON_HPNODE1;
+    node->right = POISON_HPNODE2;
+    node->parent = POISON_HPNODE3;
+
+    lazy->dead--;
+    if (lazy->release)
+        lazy->release(node, lazy->pdata);
+}
+
+/**
+ * heap_lazy_compact - drop every cancelled node from lazy heap.
+ * @lazy: lazy heap root to compact.
+ * @cmp: operator defining the node order.
+ *
+ * Each cancelled node is replaced by the last node, then the whole tree
+ * is heapified bottom-up once, in O(n) overall.
+ */
+void heap_lazy_compact(struct heap_lazy *lazy, heap_cmp_t cmp)
+{
+    struct heap_root *root = &lazy->root;
+    struct heap_node *node, *last, *prev;
+    unsigned int index = 1;
+
+    if (!root->count)
+        return;
+
+    node = root->node;
+    last = heap_find(root, root->count);
+
+    for (;;) {
+        if (!lazy->is_dead(node, lazy->pdata)) {
+            if (index == root->count)
+                break;
+            node = heap_next(root, node, index++);
+            continue;
+        }
+
+        prev = root->count > 1 ? heap_prev(root, last, root->count) : NULL;
+        heap_remove_last(root, last, last);
+
+        if (last == node) {
+            lazy_release(lazy, node);
+            break;
+        }
+
+        /* the last node fills the hole and is checked in turn */
+        if (prev == node)
+            prev = last;
+        node_transplant(root, node, last);
+        lazy_release(lazy, node);
+
+        node = last;
+        last = prev;
+    }
+
+    batch_heapify(root, 1, root->count >> 1, cmp);
+}
+
+/**
+ * heap_lazy_cancel - cancel node without rebalancing.
+ * @lazy: lazy heap root of node.
+ * @node: node already reported dead by the is_dead predicate.
+ * @cmp: operator defining the node order.
+ *
+ * The node stays in the heap until it reaches the top or the heap is
+ * compacted, and is then handed to the release callback.
+ */
+void heap_lazy_cancel(struct heap_lazy *lazy, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_root *root = &lazy->root;
+
+    lazy->dead++;
+    if (node == root->node) {
+        heap_delete(root, node, cmp);
+        lazy_release(lazy, node);
+    } else if (lazy->dead * 100UL > root->count * (unsigned long)HEAP_LAZY_RATIO)
+        heap_lazy_compact(lazy, cmp);
+}
+
+/**
+ * heap_lazy_peek - get the top live node of lazy heap.
+ * @lazy: lazy heap root to peek.
+ * @cmp: operator defining the node order.
+ *
+ * Cancelled nodes that surfaced at the top are dropped on the way.
+ */
+struct heap_node *heap_lazy_peek(struct heap_lazy *lazy, heap_cmp_t cmp)
+{
+    struct heap_root *root = &lazy->root;
+    struct heap_node *node;
+
+    while ((node = root->node) && lazy->dead) {
+        if (!lazy->is_dead(node, lazy->pdata))
+            break;
+        heap_delete(root, node, cmp);
+        lazy_release(lazy, node);
+    }
+
+    return node;
+}
+
+static __always_inline struct heap_node *
+post_deepest(struct heap_node *node)
+{
+    for (;;) {
+        if (node->left)
+            node = node->left;
+        else if (node->right)
+            node = node->right;
+        else
+            return node;
+    }
+}
+
+/**
+ * heap_post_first - get the postorder first node of heaptree.
+ * @root: heaptree to iterate.
+ */
+struct heap_node *heap_post_first(const struct heap_root *root)
+{
+    return root->node ? post_deepest(root->node) : NULL;
+}
+
+/**
+ * heap_post_next - get the postorder next node.
+ * @node: current node, only its parent link is read.
+ *
+ * Children are always visited before their parent, so @node may be
+ * released as soon as this returns.
+ */
+struct heap_node *heap_post_next(const struct heap_node *node)
+{
+    struct heap_node *parent = node->parent;
+
+    if (parent && node == parent->left && parent->right)
+        return post_deepest(parent->right);
+
+    return parent;
+}
+
+/**
+ * heap_destroy - release every node of heaptree without sifting.
+ * @root: heaptree to destroy.
+ * @release: called once per node, children before parents.
+ * @pdata: private data of @release.
+ *
+ * O(n) and never calls the comparator, @root is left empty.
+ */
+void heap_destroy(struct heap_root *root, heap_release_t release, void *pdata)
+{
+    struct heap_node *node, *next;
+
+    for (node = heap_post_first(root); node; node = next) {
+        next = heap_post_next(node);
+        release(node, pdata);
+    }
+
+    heap_clear(root);
+}
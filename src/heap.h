@@ -10,15 +10,75 @@
 #define likely(x)   __builtin_expect(!!(x), 1)
 #define unlikely(x) __builtin_expect(!!(x), 0)
 
+#ifndef HEAP_PREFETCH
+# define HEAP_PREFETCH 1
+#endif
+
+#if HEAP_PREFETCH
+# define heap_prefetch(ptr) __builtin_prefetch(ptr)
+#else
+# define heap_prefetch(ptr) ((void)(ptr))
+#endif
+
 struct heap_node {
     struct heap_node *parent;
     struct heap_node *left;
     struct heap_node *right;
 };
 
+/*
+ * Work counters of one heap, only present when built with HEAP_STATS:
+ *   @cmps: comparator calls.
+ *   @swaps: node exchanges (slot moves for array heaps, links for pairing).
+ *   @fixups/@ups: sift-up passes and the levels they climbed.
+ *   @fixdowns/@downs: sift-down passes and the levels they sank.
+ *   @depth: maximum depth the heap has reached.
+ */
+struct heap_stats {
+    unsigned long cmps;
+    unsigned long swaps;
+    unsigned long fixups;
+    unsigned long ups;
+    unsigned long fixdowns;
+    unsigned long downs;
+    unsigned int depth;
+};
+
 struct heap_root {
     struct heap_node *node;
     unsigned int count;
+#ifdef HEAP_STATS
+    struct heap_stats stats;
+#endif
+};
+
+/*
+ * A heap root remembering its last leaf. Sifts may move that leaf, so
+ * change @root through the heap_cached_* wrappers only.
+ */
+struct heap_root_cached {
+    struct heap_root root;
+    struct heap_node *leaf;
+};
+
+typedef bool (*heap_pred_t)(const struct heap_node *node, void *pdata);
+typedef void (*heap_release_t)(struct heap_node *node, void *pdata);
+
+struct heap_lazy {
+    struct heap_root root;
+    unsigned int dead;
+    heap_pred_t is_dead;
+    heap_release_t release;
+    void *pdata;
+};
+
+/*
+ * Bounded heaps keep at most @limit nodes, the top being the worst one
+ * kept, so a candidate that does not beat it is rejected outright.
+ */
+struct heap_bounded {
+    struct heap_root root;
+    unsigned int limit;
 };
 
 #define HEAP_STATIC \
@@ -30,9 +90,33 @@ struct heap_root {
 #define HEAP_INIT \
     (struct heap_root) HEAP_STATIC
 
+#define HEAP_LAZY_STATIC(is_dead, release, pdata) \
+    {HEAP_STATIC, 0, is_dead, release, pdata}
+
+#define HEAP_CACHED_INIT \
+    (struct heap_root_cached) HEAP_CACHED_STATIC
+
+#define HEAP_LAZY_INIT(is_dead, release, pdata) \
+    (struct heap_lazy) HEAP_LAZY_STATIC(is_dead, release, pdata)
+
+#define HEAP_BOUNDED_STATIC(limit) \
+    {HEAP_STATIC, limit}
+
+#define HEAP_BOUNDED_INIT(limit) \
+    (struct heap_bounded) HEAP_BOUNDED_STATIC(limit)
+
 #define HEAP_ROOT(name) \
     struct heap_root name = HEAP_INIT
 
+#define HEAP_CACHED_ROOT(name) \
+    struct heap_root_cached name = HEAP_CACHED_INIT
+
+#define HEAP_LAZY_ROOT(name, is_dead, release, pdata) \
+    struct heap_lazy name = HEAP_LAZY_INIT(is_dead, release, pdata)
+
+#define HEAP_BOUNDED_ROOT(name, limit) \
+    struct heap_bounded name = HEAP_BOUNDED_INIT(limit)
+
 #define HEAP_EMPTY_ROOT(root) \
     ((root)->node == NULL)
 
@@ -48,6 +132,26 @@ struct heap_root {
 #define HEAP_NODE_COUNT(root) \
     ((root)->count)
 
+#define HEAP_CACHED_LEAF(cached) \
+    ((cached)->leaf)
+
+#define HEAP_LAZY_DEAD(lazy) \
+    ((lazy)->dead)
+
+#define HEAP_LAZY_LIVE(lazy) \
+    ((lazy)->root.count - (lazy)->dead)
+
+#define HEAP_BOUNDED_FULL(bounded) \
+    ((bounded)->root.count >= (bounded)->limit)
+
+/*
+ * Lazy heaps compact themselves once more than HEAP_LAZY_RATIO percent
+ * of their nodes have been cancelled.
+ */
+#ifndef HEAP_LAZY_RATIO
+# define HEAP_LAZY_RATIO 50
+#endif
+
 /**
  * heap_entry - get the struct for this entry.
  * @ptr: the &struct heap_node pointer.
@@ -83,20 +187,492 @@ extern bool heap_debug_link_check(struct heap_node *parent, struct heap_node **l
 extern bool heap_debug_delete_check(struct heap_node *node);
 #endif
 
+#ifdef HEAP_STATS
+# define heap_stats_add(stats, field, value) ((stats)->field += (value))
+# define heap_stats_cmp(stats, cmp, nodea, nodeb) ((stats)->cmps++, cmp(nodea, nodeb))
+# define heap_stats_depth(stats, level) do {  \
+    if ((level) > (stats)->depth)               \
+        (stats)->depth = (level);               \
+} while (0)
+# define heap_stats_reset(stats) \
+    (*(stats) = (struct heap_stats){0})
+#else
+# define heap_stats_add(stats, field, value) ((void)0)
+# define heap_stats_cmp(stats, cmp, nodea, nodeb) cmp(nodea, nodeb)
+# define heap_stats_depth(stats, level) ((void)0)
+# define heap_stats_reset(stats) ((void)0)
+#endif
+
+/*
+ * Hole-based sifts find the final position first and then move every
+ * node on the path exactly once, instead of an exchange per level.
+ */
+#ifndef HEAP_HOLE
+# define HEAP_HOLE 1
+#endif
+
 typedef long (*heap_cmp_t)(const struct heap_node *nodea, const struct heap_node *nodeb);
+
+/**
+ * heap_parent_swap - exchange the position of a node and its parent.
+ * @root: heap root of node.
+ * @parent: parent node of @node.
+ * @node: child node of @parent.
+ */
+static __always_inline void
+heap_parent_swap(struct heap_root *root, struct heap_node *parent, struct heap_node *node)
+{
+    struct heap_node *gparent = parent->parent;
+    struct heap_node shadow = *node;
+
+    heap_stats_add(&root->stats, swaps, 1);
+    if (node->left)
+        node->left->parent = parent;
+    if (node->right)
+        node->right->parent = parent;
+
+    if (parent->left == node) {
+        node->left = parent;
+        if ((node->right = parent->right))
+            parent->right->parent = node;
+    } else { /* parent->right == node */
+        node->right = parent;
+        if ((node->left = parent->left))
+            parent->left->parent = node;
+    }
+
+    if (!(node->parent = gparent))
+        root->node = node;
+    else if (gparent->left == parent)
+        gparent->left = node;
+    else /* gparent->right == parent */
+        gparent->right = node;
+
+    *parent = shadow;
+    parent->parent = node;
+}
+
+/**
+ * heap_hole_link - get the link pointing to node.
+ * @root: heap root of node.
+ * @node: node to look up.
+ */
+static __always_inline struct heap_node **
+heap_hole_link(struct heap_root *root, struct heap_node *node)
+{
+    struct heap_node *parent = node->parent;
+
+    if (!parent)
+        return &root->node;
+    else if (parent->left == node)
+        return &parent->left;
+    else /* parent->right == node */
+        return &parent->right;
+}
+
+/**
+ * heap_hole_up - rotate node up over its @levels nearest ancestors.
+ * @root: heap root of node.
+ * @node: node to lift.
+ * @top: highest ancestor moving one level down.
+ * @path: one bit per level from @node upward, set for a right child.
+ * @levels: number of ancestors moving down.
+ *
+ * Each node on the path is written once from the top down, and only
+ * the sibling beside each level has its parent link rewritten.
+ */
+static __always_inline void
+heap_hole_up(struct heap_root *root, struct heap_node *node, struct heap_node *top,
+             unsigned long path, unsigned int levels)
+{
+    struct heap_node *left = node->left, *right = node->right;
+    struct heap_node *parent = top->parent, **link, *occupant = node;
+    struct heap_node *walk = top, *sibling, *next;
+
+    link = heap_hole_link(root, top);
+    while (levels--) {
+        if ((path >> levels) & 1) {
+            sibling = walk->left;
+            next = walk->right;
+        } else {
+            sibling = walk->right;
+            next = walk->left;
+        }
+
+        *link = occupant;
+        occupant->parent = parent;
+        if ((path >> levels) & 1) {
+            occupant->left = sibling;
+            link = &occupant->right;
+        } else {
+            occupant->right = sibling;
+            link = &occupant->left;
+        }
+        if (sibling)
+            sibling->parent = occupant;
+
+        parent = occupant;
+        occupant = walk;
+        walk = next;
+    }
+
+    *link = occupant;
+    occupant->parent = parent;
+    if ((occupant->left = left))
+        left->parent = occupant;
+    if ((occupant->right = right))
+        right->parent = occupant;
+}
+
+/**
+ * heap_hole_down - rotate node down along the path of its successors.
+ * @root: heap root of node.
+ * @node: node to sink.
+ * @path: one bit per level from @node downward, set for a right child.
+ * @levels: number of successors moving up.
+ */
+static __always_inline void
+heap_hole_down(struct heap_root *root, struct heap_node *node,
+               unsigned long path, unsigned int levels)
+{
+    struct heap_node *left = node->left, *right = node->right;
+    struct heap_node *parent = node->parent, **link;
+    struct heap_node *successor, *sibling;
+
+    link = heap_hole_link(root, node);
+    for (; levels--; path >>= 1) {
+        if (path & 1) {
+            successor = right;
+            sibling = left;
+        } else {
+            successor = left;
+            sibling = right;
+        }
+
+        left = successor->left;
+        right = successor->right;
+
+        *link = successor;
+        successor->parent = parent;
+        if (path & 1) {
+            successor->left = sibling;
+            link = &successor->right;
+        } else {
+            successor->right = sibling;
+            link = &successor->left;
+        }
+        if (sibling)
+            sibling->parent = successor;
+
+        parent = successor;
+    }
+
+    *link = node;
+    node->parent = parent;
+    if ((node->left = left))
+        left->parent = node;
+    if ((node->right = right))
+        right->parent = node;
+}
+
+/**
+ * heap_fixup_inline - balance after insert node.
+ * @root: heap root of node.
+ * @node: new inserted node.
+ * @cmp: operator defining the node order.
+ *
+ * Always inlined, a constant @cmp is called directly rather than
+ * through a function pointer.
+ */
+static __always_inline void
+heap_fixup_inline(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *parent;
+#if HEAP_HOLE
+    struct heap_node *top = node;
+    unsigned long path = 0;
+    unsigned int levels = 0;
+
+    heap_stats_add(&root->stats, fixups, 1);
+    while ((parent = top->parent)) {
+        if (heap_stats_cmp(&root->stats, cmp, node, parent) >= 0)
+            break;
+        path |= (unsigned long)(parent->right == top) << levels++;
+        top = parent;
+    }
+
+    if (levels) {
+        heap_hole_up(root, node, top, path, levels);
+        heap_stats_add(&root->stats, swaps, levels);
+        heap_stats_add(&root->stats, ups, levels);
+    }
+#else
+    heap_stats_add(&root->stats, fixups, 1);
+    while ((parent = node->parent)) {
+        if (heap_stats_cmp(&root->stats, cmp, node, parent) >= 0)
+            break;
+        heap_parent_swap(root, parent, node);
+        heap_stats_add(&root->stats, ups, 1);
+    }
+#endif
+}
+
+/**
+ * heap_fixdown_inline - balance after node moves toward the bottom.
+ * @root: heap root of node.
+ * @node: node to sink.
+ * @cmp: operator defining the node order.
+ *
+ * Always inlined, a constant @cmp is called directly rather than
+ * through a function pointer. With HEAP_PREFETCH the grandchildren
+ * are requested while the children are being compared, so the next
+ * level is usually in cache by the time it is visited.
+ */
+static __always_inline void
+heap_fixdown_inline(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *successor, *child1, *child2;
+#if HEAP_HOLE
+    unsigned long path = 0;
+    unsigned int levels = 0;
+
+    heap_stats_add(&root->stats, fixdowns, 1);
+    child1 = node->left;
+    child2 = node->right;
+
+    while (child1) {
+        if (!child2)
+            successor = child1;
+        else {
+            heap_prefetch(child1->left);
+            heap_prefetch(child1->right);
+            heap_prefetch(child2->left);
+            heap_prefetch(child2->right);
+            if (heap_stats_cmp(&root->stats, cmp, child1, child2) < 0)
+                successor = child1;
+            else
+                successor = child2;
+        }
+
+        if (heap_stats_cmp(&root->stats, cmp, node, successor) < 0)
+            break;
+        path |= (unsigned long)(successor == child2) << levels++;
+        child1 = successor->left;
+        child2 = successor->right;
+    }
+
+    if (levels) {
+        heap_hole_down(root, node, path, levels);
+        heap_stats_add(&root->stats, swaps, levels);
+        heap_stats_add(&root->stats, downs, levels);
+    }
+#else
+    heap_stats_add(&root->stats, fixdowns, 1);
+    for (;;) {
+        child1 = node->left;
+        child2 = node->right;
+
+        if (!child1 && !child2)
+            return;
+        else if (!child2)
+            successor = node->left;
+        else if (!child1)
+            successor = node->left;
+        else { /* child1 && child2 */
+            heap_prefetch(child1->left);
+            heap_prefetch(child1->right);
+            heap_prefetch(child2->left);
+            heap_prefetch(child2->right);
+            if (heap_stats_cmp(&root->stats, cmp, node->left, node->right) < 0)
+                successor = node->left;
+            else
+                successor = node->right;
+        }
+
+        if (heap_stats_cmp(&root->stats, cmp, node, successor) < 0)
+            return;
+        heap_parent_swap(root, node, successor);
+        heap_stats_add(&root->stats, downs, 1);
+    }
+#endif
+}
+
+/**
+ * heap_erase_inline - balance after remove node.
+ * @root: heap root of node.
+ * @node: removed node.
+ * @cmp: operator defining the node order.
+ *
+ * Always inlined, a constant @cmp is called directly rather than
+ * through a function pointer.
+ */
+static __always_inline void
+heap_erase_inline(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *parent = node->parent;
+
+    if (parent && heap_stats_cmp(&root->stats, cmp, node, parent) < 0)
+        heap_fixup_inline(root, node, cmp);
+    else
+        heap_fixdown_inline(root, node, cmp);
+}
+
+/**
+ * heap_build_siftdown - sink an array slot of a heap being built.
+ * @root: heap root the build is accounted to.
+ * @nodes: array of nodes in level order.
+ * @count: number of @nodes.
+ * @index: zero based slot to sink within its own subtree.
+ * @cmp: operator defining the node order.
+ */
+static __always_inline void
+heap_build_siftdown(struct heap_root *root, struct heap_node **nodes, unsigned int count,
+                    unsigned int index, heap_cmp_t cmp)
+{
+    struct heap_node *node = nodes[index];
+    unsigned int child;
+
+    heap_stats_add(&root->stats, fixdowns, 1);
+    while ((child = (index << 1) + 1) < count) {
+        if (child + 1 < count && heap_stats_cmp(&root->stats, cmp, nodes[child + 1], nodes[child]) < 0)
+            child++;
+        if (heap_stats_cmp(&root->stats, cmp, node, nodes[child]) < 0)
+            break;
+        nodes[index] = nodes[child];
+        index = child;
+        heap_stats_add(&root->stats, swaps, 1);
+        heap_stats_add(&root->stats, downs, 1);
+    }
+
+    nodes[index] = node;
+}
+
+/**
+ * heap_build_link - link array slots of a built heap into a tree.
+ * @nodes: array of nodes in level order.
+ * @count: number of @nodes.
+ * @start: zero based first slot to link.
+ * @end: slot past the last one to link.
+ */
+static __always_inline void
+heap_build_link(struct heap_node **nodes, unsigned int count, unsigned int start, unsigned int end)
+{
+    struct heap_node *node;
+    unsigned int index, child;
+
+    for (index = start; index < end; ++index) {
+        node = nodes[index];
+        child = (index << 1) + 1;
+        node->parent = index ? nodes[(index - 1) >> 1] : NULL;
+        node->left = child < count ? nodes[child] : NULL;
+        node->right = child + 1 < count ? nodes[child + 1] : NULL;
+    }
+}
+
 extern void heap_fixup(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp);
+extern void heap_fixdown(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp);
 extern void heap_erase(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp);
 extern struct heap_node *heap_remove(struct heap_root *root, struct heap_node *node);
+extern struct heap_node *heap_remove_last(struct heap_root *root, struct heap_node *node, struct heap_node *last);
+extern struct heap_node *heap_prev(const struct heap_root *root, struct heap_node *node, unsigned int index);
+extern struct heap_node *heap_next(const struct heap_root *root, struct heap_node *node, unsigned int index);
 extern struct heap_node **heap_parent(struct heap_root *root, struct heap_node **parentp, struct heap_node *node);
-extern struct heap_node *heap_find(struct heap_root *root, unsigned int index);
+extern struct heap_node **heap_cached_parent(struct heap_root_cached *cached, struct heap_node **parentp);
+extern struct heap_node *heap_find(const struct heap_root *root, unsigned int index);
+extern void heap_replace(struct heap_root *root, struct heap_node *old, struct heap_node *new, heap_cmp_t cmp);
+extern void heap_build(struct heap_root *root, struct heap_node **nodes, unsigned int count, heap_cmp_t cmp);
+extern void heap_insert_batch(struct heap_root *root, struct heap_node **nodes, unsigned int count, heap_cmp_t cmp);
+extern unsigned int heap_pop_batch(struct heap_root *root, struct heap_node **nodes, unsigned int count, heap_cmp_t cmp);
+extern void heap_lazy_cancel(struct heap_lazy *lazy, struct heap_node *node, heap_cmp_t cmp);
+extern void heap_lazy_compact(struct heap_lazy *lazy, heap_cmp_t cmp);
+extern struct heap_node *heap_lazy_peek(struct heap_lazy *lazy, heap_cmp_t cmp);
+extern unsigned int heap_bounded_extract(struct heap_bounded *bounded, struct heap_node **nodes, heap_cmp_t cmp);
+extern unsigned int heap_pop_while(struct heap_root *root, struct heap_node **nodes, unsigned int count,
+                                   heap_pred_t pred, void *pdata, heap_cmp_t cmp);
+
+extern void heap_destroy(struct heap_root *root, heap_release_t release, void *pdata);
+
+/* Postorder iteration (Children-first) - the current node may be freed */
+extern struct heap_node *heap_post_first(const struct heap_root *root);
+extern struct heap_node *heap_post_next(const struct heap_node *node);
+
+/*
+ * Level order iteration - @index is the zero based position of the
+ * cursor. heap_level_next() descends from the root to every position,
+ * heap_level_next_node() climbs and descends along heap_next() from the
+ * cursor node instead, so a whole walk visits every edge at most twice.
+ */
+
+/**
+ * heap_level_first - get the first node and position of a level order walk.
+ * @root: heaptree to walk.
+ * @index: position of the returned node.
+ */
+static inline struct heap_node *heap_level_first(const struct heap_root *root, unsigned long *index)
+{
+    *index = 0;
+    return root->node;
+}
+
+/**
+ * heap_level_next - get the node at the position following @index.
+ * @root: heaptree to walk.
+ * @index: position to advance.
+ */
+static inline struct heap_node *heap_level_next(const struct heap_root *root, unsigned long *index)
+{
+    /* heap_find counts from one */
+    return heap_find(root, ++*index + 1);
+}
+
+/**
+ * heap_level_next_node - step a level order walk to the following node.
+ * @root: heaptree to walk.
+ * @node: node at @index.
+ * @index: position of @node, advanced along with it.
+ */
+static inline struct heap_node *heap_level_next_node(const struct heap_root *root, struct heap_node *node,
+                                                     unsigned long *index)
+{
+    /* heap_next counts from one, that is the position after the step */
+    return heap_next(root, node, ++*index);
+}
 
-/* Preorder iteration (Root-first) - always access the left node first */
-extern struct heap_node *heap_level_first(const struct heap_root *root, unsigned long *index);
-extern struct heap_node *heap_level_next(const struct heap_root *root, unsigned long *index);
+/**
+ * heap_range_first - get the first node of a level order range.
+ * @root: heaptree to walk.
+ * @index: position of the returned node.
+ * @start: zero based position the range starts at.
+ * @end: position past the end of the range.
+ */
+static inline struct heap_node *heap_range_first(const struct heap_root *root, unsigned long *index,
+                                                 unsigned long start, unsigned long end)
+{
+    *index = start;
+    if (start >= end || start >= root->count)
+        return NULL;
+    return heap_find(root, start + 1);
+}
+
+/**
+ * heap_range_next - step a level order range walk to the following node.
+ * @root: heaptree to walk.
+ * @node: node at @index.
+ * @index: position of @node, advanced along with it.
+ * @end: position past the end of the range.
+ */
+static inline struct heap_node *heap_range_next(const struct heap_root *root, struct heap_node *node,
+                                                unsigned long *index, unsigned long end)
+{
+    if (*index + 1 >= end)
+        return NULL;
+    return heap_level_next_node(root, node, index);
+}
 
 /**
- * heap_pre_first_entry - get the preorder first element from a heaptree.
- * @ptr: the heaptree root to take the element from.
+ * heap_first_entry - get the level order first element from a heaptree.
+ * @root: the heaptree root to take the element from.
+ * @index: position of the element.
  * @type: the type of the struct this is embedded in.
  * @member: the name of the heap_node within the struct.
  */
@@ -104,63 +680,143 @@ extern struct heap_node *heap_level_next(const struct heap_root *root, unsigned
     heap_entry_safe(heap_level_first(root, index), type, member)
 
 /**
- * heap_pre_next_entry - get the preorder next element in heaptree.
- * @pos: the type * to cursor.
+ * heap_next_entry - get the level order next element in heaptree.
+ * @root: the heaptree root to take the element from.
+ * @index: position to advance.
+ * @type: the type of the struct this is embedded in.
  * @member: the name of the heap_node within the struct.
  */
 #define heap_next_entry(root, index, type, member) \
     heap_entry_safe(heap_level_next(root, index), type, member)
 
 /**
- * heap_pre_for_each - preorder iterate over a heaptree.
+ * heap_next_entry_from - get the level order next element after a cursor.
+ * @pos: the type * to cursor.
+ * @root: the heaptree root of @pos.
+ * @index: position of @pos.
+ * @member: the name of the heap_node within the struct.
+ */
+#define heap_next_entry_from(pos, root, index, member) \
+    heap_entry_safe(heap_level_next_node(root, &(pos)->member, index), typeof(*(pos)), member)
+
+/**
+ * heap_for_each - level order iterate over a heaptree.
  * @pos: the &struct heap_node to use as a loop cursor.
+ * @index: position of @pos.
  * @root: the root for your heaptree.
  */
 #define heap_for_each(pos, index, root) \
     for (pos = heap_level_first(root, index); \
-         pos; pos = heap_level_next(root, index))
+         pos; pos = heap_level_next_node(root, pos, index))
 
 /**
- * heap_pre_for_each_from - preorder iterate over a heaptree from the current point.
+ * heap_for_each_from - level order iterate over a heaptree from the current point.
  * @pos: the &struct heap_node to use as a loop cursor.
+ * @index: position of @pos.
+ * @root: the root for your heaptree.
  */
 #define heap_for_each_from(pos, index, root) \
-    for (; pos; pos = heap_level_next(root, index))
+    for (; pos; pos = heap_level_next_node(root, pos, index))
 
 /**
- * heap_pre_for_each_continue - continue preorder iteration over a heaptree.
+ * heap_for_each_continue - continue level order iteration over a heaptree.
  * @pos: the &struct heap_node to use as a loop cursor.
+ * @index: position of @pos.
+ * @root: the root for your heaptree.
  */
 #define heap_for_each_continue(pos, index, root) \
-    for (pos = heap_level_next(root, index); \
-         pos; pos = heap_level_next(root, index))
+    for (pos = heap_level_next_node(root, pos, index); \
+         pos; pos = heap_level_next_node(root, pos, index))
 
 /**
- * heap_pre_for_each_entry - preorder iterate over heaptree of given type.
+ * heap_for_each_range - level order iterate over a slice of a heaptree.
+ * @pos: the &struct heap_node to use as a loop cursor.
+ * @index: position of @pos.
+ * @root: the root for your heaptree.
+ * @start: zero based position of the first node.
+ * @end: position past the last node.
+ *
+ * Disjoint slices can be walked by several threads at once as long as
+ * the heaptree is not modified, e.g. thread @k of @n walks from
+ * count * k / n to count * (k + 1) / n. Only the first step of each
+ * slice descends from the root.
+ */
+#define heap_for_each_range(pos, index, root, start, end) \
+    for (pos = heap_range_first(root, index, start, end); \
+         pos; pos = heap_range_next(root, pos, index, end))
+
+/**
+ * heap_for_each_entry - level order iterate over heaptree of given type.
  * @pos: the type * to use as a loop cursor.
+ * @index: position of @pos.
  * @root: the root for your heaptree.
  * @member: the name of the heap_node within the struct.
  */
 #define heap_for_each_entry(pos, index, root, member) \
     for (pos = heap_first_entry(root, index, typeof(*pos), member); \
-         pos; pos = heap_next_entry(root, index, typeof(*pos), member))
+         pos; pos = heap_next_entry_from(pos, root, index, member))
 
 /**
- * heap_pre_for_each_entry_from - preorder iterate over heaptree of given type from the current point.
+ * heap_for_each_entry_from - level order iterate over heaptree of given type from the current point.
  * @pos: the type * to use as a loop cursor.
+ * @index: position of @pos.
+ * @root: the root for your heaptree.
  * @member: the name of the heap_node within the struct.
  */
 #define heap_for_each_entry_from(pos, index, root, member) \
-    for (; pos; pos = heap_next_entry(root, index, typeof(*pos), member))
+    for (; pos; pos = heap_next_entry_from(pos, root, index, member))
 
 /**
- * heap_pre_for_each_entry_continue - continue preorder iteration over heaptree of given type.
+ * heap_for_each_entry_continue - continue level order iteration over heaptree of given type.
  * @pos: the type * to use as a loop cursor.
+ * @index: position of @pos.
+ * @root: the root for your heaptree.
  * @member: the name of the heap_node within the struct.
  */
 #define heap_for_each_entry_continue(pos, index, root, member) \
-    for (pos = heap_next_entry(root, index, typeof(*pos), member); \
-         pos; pos = heap_next_entry(root, index, typeof(*pos), member))
+    for (pos = heap_next_entry_from(pos, root, index, member); \
+         pos; pos = heap_next_entry_from(pos, root, index, member))
+
+/**
+ * heap_for_each_entry_range - level order iterate over a slice of heaptree of given type.
+ * @pos: the type * to use as a loop cursor.
+ * @index: position of @pos.
+ * @root: the root for your heaptree.
+ * @start: zero based position of the first node.
+ * @end: position past the last node.
+ * @member: the name of the heap_node within the struct.
+ */
+#define heap_for_each_entry_range(pos, index, root, start, end, member) \
+    for (pos = heap_entry_safe(heap_range_first(root, index, start, end), typeof(*pos), member); \
+         pos; pos = heap_entry_safe(heap_range_next(root, &pos->member, index, end), \
+                                    typeof(*pos), member))
+
+/**
+ * heap_for_each_safe - postorder iterate over a heaptree safe against removal.
+ * @pos: the &struct heap_node to use as a loop cursor.
+ * @next: another &struct heap_node to use as temporary storage.
+ * @root: the root for your heaptree.
+ *
+ * The heaptree is not rebalanced, freeing @pos is fine but it must not
+ * be deleted through the heap api, drop the whole tree afterwards.
+ */
+#define heap_for_each_safe(pos, next, root) \
+    for (pos = heap_post_first(root); \
+         pos && ({next = heap_post_next(pos); 1;}); \
+         pos = next)
+
+/**
+ * heap_for_each_entry_safe - postorder iterate over heaptree of given type safe against removal.
+ * @pos: the type * to use as a loop cursor.
+ * @next: another type * to use as temporary storage.
+ * @root: the root for your heaptree.
+ * @member: the name of the heap_node within the struct.
+ */
+#define heap_for_each_entry_safe(pos, next, root, member) \
+    for (pos = heap_entry_safe(heap_post_first(root), typeof(*pos), member); \
+         pos && ({next = heap_entry_safe(heap_post_next(&pos->member), \
+                  typeof(*pos), member); 1;}); \
+         pos = next)
 
 /**
  * heap_link - link node to parent.
@@ -182,6 +838,7 @@ static inline void heap_link(struct heap_root *root, struct heap_node *parent,
     node->parent = parent;
     node->left = node->right = NULL;
     root->count++;
+    heap_stats_depth(&root->stats, 64U - __builtin_clzll(root->count));
 }
 
 /**
@@ -234,4 +891,269 @@ static inline void heap_delete(struct heap_root *root, struct heap_node *node, h
     node->parent = POISON_HPNODE3;
 }
 
+/**
+ * heap_clear - forget every node of heaptree without sifting.
+ * @root: heaptree root to clear.
+ *
+ * Nodes are not visited and keep their links, use this when their
+ * memory is released in bulk, e.g. by heap_pool_destroy().
+ */
+static inline void heap_clear(struct heap_root *root)
+{
+    root->node = NULL;
+    root->count = 0;
+}
+
+/**
+ * heap_update - rebalance node after its order changed.
+ * @root: heaptree root of node.
+ * @node: node whose order has changed.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_update(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    heap_erase(root, node, cmp);
+}
+
+/**
+ * heap_decrease_key - rebalance node after it moved toward the top.
+ * @root: heaptree root of node.
+ * @node: node whose order has decreased.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_decrease_key(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    heap_fixup(root, node, cmp);
+}
+
+/**
+ * heap_increase_key - rebalance node after it moved toward the bottom.
+ * @root: heaptree root of node.
+ * @node: node whose order has increased.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_increase_key(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    heap_fixdown(root, node, cmp);
+}
+
+/**
+ * heap_pushpop - insert node and then delete the top node.
+ * @root: heaptree root of node.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ *
+ * Returns @node itself if it would have been the new top, the heaptree
+ * is left untouched then. Otherwise @node replaces the top in place and
+ * the former top is returned.
+ */
+static inline struct heap_node *heap_pushpop(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *top = root->node;
+
+    if (!top || heap_stats_cmp(&root->stats, cmp, node, top) < 0)
+        return node;
+
+    heap_replace(root, top, node, cmp);
+    return top;
+}
+
+/**
+ * heap_cached_insert - insert new node into cached heaptree.
+ * @cached: cached heaptree root of node.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_cached_insert(struct heap_root_cached *cached, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *parent, **link;
+
+    link = heap_cached_parent(cached, &parent);
+    heap_insert_node(&cached->root, parent, link, node, cmp);
+
+    /* the first parent swapped down lands in the last slot */
+    cached->leaf = node->parent == parent ? node : parent;
+}
+
+/**
+ * heap_cached_fixup - balance cached heaptree after node moves toward the top.
+ * @cached: cached heaptree root of node.
+ * @node: node whose order has decreased.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_cached_fixup(struct heap_root_cached *cached, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *parent = node->parent;
+
+    heap_fixup(&cached->root, node, cmp);
+    if (cached->leaf == node && node->parent != parent)
+        cached->leaf = parent;
+}
+
+/**
+ * heap_cached_fixdown - balance cached heaptree after node moves toward the bottom.
+ * @cached: cached heaptree root of node.
+ * @node: node whose order has increased.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_cached_fixdown(struct heap_root_cached *cached, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *leaf = cached->leaf;
+
+    heap_fixdown(&cached->root, node, cmp);
+
+    /* the leaf has no children, so above node it must have been swapped */
+    if (leaf && node->parent == leaf)
+        cached->leaf = node;
+}
+
+/**
+ * heap_cached_update - rebalance cached heaptree after node order changed.
+ * @cached: cached heaptree root of node.
+ * @node: node whose order has changed.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_cached_update(struct heap_root_cached *cached, struct heap_node *node, heap_cmp_t cmp)
+{
+    if (node->parent && heap_stats_cmp(&cached->root.stats, cmp, node, node->parent) < 0)
+        heap_cached_fixup(cached, node, cmp);
+    else
+        heap_cached_fixdown(cached, node, cmp);
+}
+
+/**
+ * heap_cached_delete - delete node from cached heaptree.
+ * @cached: cached heaptree root of node.
+ * @node: node to delete.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_cached_delete(struct heap_root_cached *cached, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_root *root = &cached->root;
+    struct heap_node *leaf, *parent, *rebalance;
+
+#ifdef DEBUG_HEAP
+    if (unlikely(!heap_debug_delete_check(node)))
+        return;
+#endif
+
+    /* the slot before the current leaf becomes the last one */
+    leaf = root->count > 1 ? heap_prev(root, cached->leaf, root->count) : NULL;
+    if (leaf == node)
+        leaf = cached->leaf;
+
+    parent = node->parent;
+    if ((rebalance = heap_remove_last(root, node, cached->leaf))) {
+        heap_erase(root, rebalance, cmp);
+        if (leaf == rebalance)
+            leaf = rebalance->parent == parent ? rebalance : parent;
+        else if (leaf->left || leaf->right)
+            leaf = rebalance;
+    }
+
+    cached->leaf = leaf;
+    node->left = POISON_HPNODE1;
+    node->right = POISON_HPNODE2;
+    node->parent = POISON_HPNODE3;
+}
+
+/**
+ * heap_lazy_insert - insert new node into lazy heaptree.
+ * @lazy: lazy heaptree root of node.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+static inline void heap_lazy_insert(struct heap_lazy *lazy, struct heap_node *node, heap_cmp_t cmp)
+{
+    heap_insert(&lazy->root, node, cmp);
+}
+
+/**
+ * heap_lazy_pop - delete and return the top live node of lazy heaptree.
+ * @lazy: lazy heaptree to pop.
+ * @cmp: operator defining the node order.
+ */
+static inline struct heap_node *heap_lazy_pop(struct heap_lazy *lazy, heap_cmp_t cmp)
+{
+    struct heap_node *node;
+
+    if ((node = heap_lazy_peek(lazy, cmp)))
+        heap_delete(&lazy->root, node, cmp);
+
+    return node;
+}
+
+/**
+ * heap_offer - offer node to bounded heaptree.
+ * @bounded: bounded heaptree to offer to.
+ * @node: candidate node.
+ * @cmp: operator defining the node order, the top is dropped first.
+ *
+ * Until @bounded is full @node is simply inserted and NULL returned.
+ * After that one comparison against the top rejects a candidate that
+ * would be dropped first anyway, returning @node itself; otherwise
+ * @node replaces the top in place and the evicted top is returned.
+ */
+static inline struct heap_node *heap_offer(struct heap_bounded *bounded, struct heap_node *node, heap_cmp_t cmp)
+{
+    if (!HEAP_BOUNDED_FULL(bounded)) {
+        heap_insert(&bounded->root, node, cmp);
+        return NULL;
+    }
+
+    return heap_pushpop(&bounded->root, node, cmp);
+}
+
+/**
+ * HEAP_DEFINE - generate a heaptree api specialized for one comparator.
+ * @HSTATIC: storage class of the generated functions.
+ * @HNAME: prefix of the generated functions.
+ * @HCMP: comparator with the &heap_cmp_t signature.
+ *
+ * Generates @HNAME_fixup, @HNAME_fixdown, @HNAME_erase, @HNAME_insert and
+ * @HNAME_delete, which behave like their generic counterparts but call
+ * @HCMP directly, so that it can be inlined into every sift step.
+ */
+#define HEAP_DEFINE(HSTATIC, HNAME, HCMP)                                   \
+HSTATIC void                                                                \
+HNAME##_fixup(struct heap_root *root, struct heap_node *node)               \
+{                                                                           \
+    heap_fixup_inline(root, node, HCMP);                                    \
+}                                                                           \
+                                                                            \
+HSTATIC void                                                                \
+HNAME##_fixdown(struct heap_root *root, struct heap_node *node)             \
+{                                                                           \
+    heap_fixdown_inline(root, node, HCMP);                                  \
+}                                                                           \
+                                                                            \
+HSTATIC void                                                                \
+HNAME##_erase(struct heap_root *root, struct heap_node *node)               \
+{                                                                           \
+    heap_erase_inline(root, node, HCMP);                                    \
+}                                                                           \
+                                                                            \
+HSTATIC void                                                                \
+HNAME##_insert(struct heap_root *root, struct heap_node *node)              \
+{                                                                           \
+    struct heap_node *parent, **link;                                       \
+                                                                            \
+    link = heap_parent(root, &parent, node);                                \
+    heap_link(root, parent, link, node);                                    \
+    HNAME##_fixup(root, node);                                              \
+}                                                                           \
+                                                                            \
+HSTATIC void                                                                \
+HNAME##_delete(struct heap_root *root, struct heap_node *node)              \
+{                                                                           \
+    struct heap_node *rebalance;                                            \
+                                                                            \
+    if ((rebalance = heap_remove(root, node)))                              \
+        HNAME##_erase(root, rebalance);                                     \
+                                                                            \
+    node->left = POISON_HPNODE1;                                            \
+    node->right = POISON_HPNODE2;                                           \
+    node->parent = POISON_HPNODE3;                                          \
+}
+
 #endif  /* _HEAP_H_ */
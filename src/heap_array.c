@@ -0,0 +1,551 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_array.h"
+
+#define ARRAY_PARENT(index, ways) (((index) - 1) / (ways))
+#define ARRAY_CHILD(index, ways) ((index) * (ways) + 1)
+
+/*
+ * ARRAY_SIFT_DEFINE - generate the hole-carrying sifts of one array layout.
+ * @name: prefix of the generated name##_fixup() and name##_erase().
+ * @htype: heap type, with @count and, under HEAP_STATS, @stats.
+ * @etype: type of the element carried in the hole.
+ * @load: load(heap, slot) reads the element of a slot.
+ * @store: store(heap, slot, elem) writes an element into a slot.
+ * @before: before(heap, cmp, elema, elemb) tells whether @elema belongs
+ * above @elemb, counting the compare into the stats.
+ *
+ * Every array layout sifts through these loops, so they all behave and
+ * count the same way.
+ */
+#define ARRAY_SIFT_DEFINE(name, htype, etype, load, store, before)              \
+static __always_inline void                                                     \
+name##_fixup(htype *heap, unsigned int index,                                   \
+             heap_array_cmp_t cmp, const unsigned int ways)                     \
+{                                                                               \
+    etype elem = load(heap, index);                                             \
+    unsigned int parent;                                                        \
+                                                                                \
+    /* carry a hole up instead of swapping on every level */                    \
+    heap_stats_add(&heap->stats, fixups, 1);                                    \
+    while (index) {                                                             \
+        parent = ARRAY_PARENT(index, ways);                                     \
+        if (!before(heap, cmp, elem, load(heap, parent)))                       \
+            break;                                                              \
+        store(heap, index, load(heap, parent));                                 \
+        index = parent;                                                         \
+        heap_stats_add(&heap->stats, swaps, 1);                                 \
+        heap_stats_add(&heap->stats, ups, 1);                                   \
+    }                                                                           \
+                                                                                \
+    store(heap, index, elem);                                                   \
+}                                                                               \
+                                                                                \
+static __always_inline void                                                     \
+name##_erase(htype *heap, unsigned int index,                                   \
+             heap_array_cmp_t cmp, const unsigned int ways)                     \
+{                                                                               \
+    etype elem = load(heap, index);                                             \
+    unsigned int child, last, walk;                                             \
+                                                                                \
+    if (index && before(heap, cmp, elem, load(heap, ARRAY_PARENT(index, ways)))) { \
+        name##_fixup(heap, index, cmp, ways);                                   \
+        return;                                                                 \
+    }                                                                           \
+                                                                                \
+    heap_stats_add(&heap->stats, fixdowns, 1);                                  \
+    while ((child = ARRAY_CHILD(index, ways)) < heap->count) {                  \
+        last = child + ways;                                                    \
+        if (last > heap->count)                                                 \
+            last = heap->count;                                                 \
+                                                                                \
+        /* siblings share one cache line, scan them all */                      \
+        for (walk = child + 1; walk < last; ++walk)                             \
+            if (before(heap, cmp, load(heap, walk), load(heap, child)))         \
+                child = walk;                                                   \
+                                                                                \
+        if (before(heap, cmp, elem, load(heap, child)))                         \
+            break;                                                              \
+        store(heap, index, load(heap, child));                                  \
+        index = child;                                                          \
+        heap_stats_add(&heap->stats, swaps, 1);                                 \
+        heap_stats_add(&heap->stats, downs, 1);                                 \
+    }                                                                           \
+                                                                                \
+    store(heap, index, elem);                                                   \
+}
+
+#define ARRAY_LOAD(array, slot) ((array)->nodes[slot])
+#define ARRAY_STORE(array, slot, node) ((array)->nodes[slot] = (node))
+#define ARRAY_BEFORE(array, cmp, nodea, nodeb) \
+    (heap_stats_cmp(&(array)->stats, cmp, nodea, nodeb) < 0)
+
+ARRAY_SIFT_DEFINE(array, struct heap_array, void *, ARRAY_LOAD, ARRAY_STORE, ARRAY_BEFORE)
+
+#ifdef HEAP_STATS
+static __always_inline void
+array_depth(struct heap_array *array, const unsigned int ways)
+{
+    unsigned int depth = 1, index = array->count - 1;
+
+    /* levels from the root down to the last slot */
+    for (; index; index = ARRAY_PARENT(index, ways))
+        depth++;
+    heap_stats_depth(&array->stats, depth);
+}
+#else
+# define array_depth(array, ways) ((void)(array))
+#endif
+
+static __always_inline void *
+array_delete(struct heap_array *array, unsigned int index,
+             heap_array_cmp_t cmp, const unsigned int ways)
+{
+    void **nodes = array->nodes;
+    void *node = nodes[index];
+
+    if (index != --array->count) {
+        nodes[index] = nodes[array->count];
+        array_erase(array, index, cmp, ways);
+    }
+
+    return node;
+}
+
+/**
+ * heap_array_fixup - balance after node moves toward the top.
+ * @array: array heap of node.
+ * @index: index of the node.
+ * @cmp: operator defining the node order.
+ */
+void heap_array_fixup(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp)
+{
+    array_fixup(array, index, cmp, 2);
+}
+
+/**
+ * heap_array_erase - balance after node order changed.
+ * @array: array heap of node.
+ * @index: index of the node.
+ * @cmp: operator defining the node order.
+ */
+void heap_array_erase(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp)
+{
+    array_erase(array, index, cmp, 2);
+}
+
+/**
+ * heap_array_insert - insert new node into array heap.
+ * @array: array heap to insert.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+int heap_array_insert(struct heap_array *array, void *node, heap_array_cmp_t cmp)
+{
+    if (unlikely(array->count == array->capacity))
+        return -ENOSPC;
+
+    array->nodes[array->count] = node;
+    array_fixup(array, array->count++, cmp, 2);
+    array_depth(array, 2);
+
+    return 0;
+}
+
+/**
+ * heap_array_delete - delete node at index from array heap.
+ * @array: array heap of node.
+ * @index: index of the node to delete.
+ * @cmp: operator defining the node order.
+ */
+void *heap_array_delete(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp)
+{
+    return array_delete(array, index, cmp, 2);
+}
+
+/**
+ * heap_dary_init - initialize a d-ary heap on buffer.
+ * @array: d-ary heap to initialize.
+ * @buffer: storage aligned to HEAP_DARY_ALIGN.
+ * @size: number of slots in @buffer, see HEAP_DARY_SIZE.
+ *
+ * The first HEAP_DARY_WAYS - 1 slots are left unused, which shifts every
+ * sibling group onto an aligned boundary.
+ */
+void heap_dary_init(struct heap_array *array, void **buffer, unsigned int size)
+{
+    array->nodes = buffer + HEAP_DARY_WAYS - 1;
+    array->count = 0;
+    array->capacity = size > HEAP_DARY_WAYS - 1 ? size - (HEAP_DARY_WAYS - 1) : 0;
+    heap_stats_reset(&array->stats);
+}
+
+/**
+ * heap_dary_fixup - balance after node moves toward the top.
+ * @array: d-ary heap of node.
+ * @index: index of the node.
+ * @cmp: operator defining the node order.
+ */
+void heap_dary_fixup(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp)
+{
+    array_fixup(array, index, cmp, HEAP_DARY_WAYS);
+}
+
+/**
+ * heap_dary_erase - balance after node order changed.
+ * @array: d-ary heap of node.
+ * @index: index of the node.
+ * @cmp: operator defining the node order.
+ */
+void heap_dary_erase(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp)
+{
+    array_erase(array, index, cmp, HEAP_DARY_WAYS);
+}
+
+/**
+ * heap_dary_insert - insert new node into d-ary heap.
+ * @array: d-ary heap to insert.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+int heap_dary_insert(struct heap_array *array, void *node, heap_array_cmp_t cmp)
+{
+    if (unlikely(array->count == array->capacity))
+        return -ENOSPC;
+
+    array->nodes[array->count] = node;
+    array_fixup(array, array->count++, cmp, HEAP_DARY_WAYS);
+    array_depth(array, HEAP_DARY_WAYS);
+
+    return 0;
+}
+
+/**
+ * heap_dary_delete - delete node at index from d-ary heap.
+ * @array: d-ary heap of node.
+ * @index: index of the node to delete.
+ * @cmp: operator defining the node order.
+ */
+void *heap_dary_delete(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp)
+{
+    return array_delete(array, index, cmp, HEAP_DARY_WAYS);
+}
+
+/* keys are compared inline, the keyed sifts pass no comparator */
+#define KEYED_LOAD(keyed, slot) ((keyed)->slots[slot])
+#define KEYED_STORE(keyed, slot, elem) ((keyed)->slots[slot] = (elem))
+#define KEYED_BEFORE(keyed, cmp, slota, slotb) \
+    (heap_stats_add(&(keyed)->stats, cmps, 1), (slota).key < (slotb).key)
+
+ARRAY_SIFT_DEFINE(keyed, struct heap_keyed, struct heap_keyed_slot, KEYED_LOAD, KEYED_STORE, KEYED_BEFORE)
+
+static __always_inline void *
+keyed_delete(struct heap_keyed *keyed, unsigned int index, const unsigned int ways)
+{
+    struct heap_keyed_slot *slots = keyed->slots;
+    void *node = slots[index].node;
+
+    if (index != --keyed->count) {
+        slots[index] = slots[keyed->count];
+        keyed_erase(keyed, index, NULL, ways);
+    }
+
+    return node;
+}
+
+static __always_inline int
+keyed_insert(struct heap_keyed *keyed, uint64_t key, void *node, const unsigned int ways)
+{
+    if (unlikely(keyed->count == keyed->capacity))
+        return -ENOSPC;
+
+    keyed->slots[keyed->count].key = key;
+    keyed->slots[keyed->count].node = node;
+    keyed_fixup(keyed, keyed->count++, NULL, ways);
+
+    return 0;
+}
+
+static __always_inline bool
+keyed_rebase(struct heap_keyed *keyed, const unsigned int ways)
+{
+    struct heap_keyed_slot *slots = keyed->slots;
+    unsigned int count = keyed->count, index;
+    struct heap_keyed_slot slot;
+
+    if (count > HEAP_KEYED_SEQ_MASK)
+        return false;
+
+    /* pop every slot behind the shrinking heap, largest key first */
+    while (keyed->count) {
+        slot = slots[0];
+        keyed_delete(keyed, 0, ways);
+        slots[keyed->count] = slot;
+    }
+
+    /* ascending keys are a valid heap of any fan-out */
+    for (index = 0; index < count / 2; ++index) {
+        slot = slots[index];
+        slots[index] = slots[count - index - 1];
+        slots[count - index - 1] = slot;
+    }
+
+    /* renumber densely in key order, which keeps every order */
+    for (index = 0; index < count; ++index)
+        slots[index].key = (slots[index].key & ~HEAP_KEYED_SEQ_MASK) | index;
+    keyed->count = count;
+    keyed->seq = count;
+
+    return true;
+}
+
+static __always_inline int
+keyed_stable_insert(struct heap_keyed *keyed, uint64_t priority, void *node, const unsigned int ways)
+{
+    if (unlikely(keyed->count == keyed->capacity))
+        return -ENOSPC;
+
+    if (unlikely(keyed->seq > HEAP_KEYED_SEQ_MASK) && !keyed_rebase(keyed, ways))
+        return -EOVERFLOW;
+
+    return keyed_insert(keyed, priority << HEAP_KEYED_SEQ_BITS | keyed->seq++, node, ways);
+}
+
+/**
+ * heap_keyed_fixup - balance after key decreased.
+ * @keyed: keyed heap of node.
+ * @index: index of the slot.
+ */
+void heap_keyed_fixup(struct heap_keyed *keyed, unsigned int index)
+{
+    keyed_fixup(keyed, index, NULL, 2);
+}
+
+/**
+ * heap_keyed_erase - balance after key changed.
+ * @keyed: keyed heap of node.
+ * @index: index of the slot.
+ */
+void heap_keyed_erase(struct heap_keyed *keyed, unsigned int index)
+{
+    keyed_erase(keyed, index, NULL, 2);
+}
+
+/**
+ * heap_keyed_insert - insert node with key into keyed heap.
+ * @keyed: keyed heap to insert.
+ * @key: order of @node.
+ * @node: new node to insert.
+ */
+int heap_keyed_insert(struct heap_keyed *keyed, uint64_t key, void *node)
+{
+    return keyed_insert(keyed, key, node, 2);
+}
+
+/**
+ * heap_keyed_stable_insert - insert node behind its equal priorities.
+ * @keyed: keyed heap to insert.
+ * @priority: order of @node, at most 64 - HEAP_KEYED_SEQ_BITS bits.
+ * @node: new node to insert.
+ *
+ * Once the sequence space is used up, the queued slots are sorted and
+ * renumbered from zero in key order. Returns -EOVERFLOW only if more
+ * than HEAP_KEYED_SEQ_MASK slots are queued at that point.
+ */
+int heap_keyed_stable_insert(struct heap_keyed *keyed, uint64_t priority, void *node)
+{
+    return keyed_stable_insert(keyed, priority, node, 2);
+}
+
+/**
+ * heap_keyed_delete - delete slot at index from keyed heap.
+ * @keyed: keyed heap of node.
+ * @index: index of the slot to delete.
+ */
+void *heap_keyed_delete(struct heap_keyed *keyed, unsigned int index)
+{
+    return keyed_delete(keyed, index, 2);
+}
+
+/**
+ * heap_keyed_dary_init - initialize a keyed d-ary heap on buffer.
+ * @keyed: keyed d-ary heap to initialize.
+ * @buffer: storage aligned to HEAP_DARY_ALIGN.
+ * @size: number of slots in @buffer, see HEAP_KEYED_DARY_SIZE.
+ */
+void heap_keyed_dary_init(struct heap_keyed *keyed, struct heap_keyed_slot *buffer, unsigned int size)
+{
+    keyed->slots = buffer + HEAP_KEYED_WAYS - 1;
+    keyed->count = 0;
+    keyed->seq = 0;
+    heap_stats_reset(&keyed->stats);
+    keyed->capacity = size > HEAP_KEYED_WAYS - 1 ? size - (HEAP_KEYED_WAYS - 1) : 0;
+}
+
+/**
+ * heap_keyed_dary_fixup - balance after key decreased.
+ * @keyed: keyed d-ary heap of node.
+ * @index: index of the slot.
+ */
+void heap_keyed_dary_fixup(struct heap_keyed *keyed, unsigned int index)
+{
+    keyed_fixup(keyed, index, NULL, HEAP_KEYED_WAYS);
+}
+
+/**
+ * heap_keyed_dary_erase - balance after key changed.
+ * @keyed: keyed d-ary heap of node.
+ * @index: index of the slot.
+ */
+void heap_keyed_dary_erase(struct heap_keyed *keyed, unsigned int index)
+{
+    keyed_erase(keyed, index, NULL, HEAP_KEYED_WAYS);
+}
+
+/**
+ * heap_keyed_dary_insert - insert node with key into keyed d-ary heap.
+ * @keyed: keyed d-ary heap to insert.
+ * @key: order of @node.
+ * @node: new node to insert.
+ */
+int heap_keyed_dary_insert(struct heap_keyed *keyed, uint64_t key, void *node)
+{
+    return keyed_insert(keyed, key, node, HEAP_KEYED_WAYS);
+}
+
+/**
+ * heap_keyed_dary_stable_insert - insert node behind its equal priorities.
+ * @keyed: keyed d-ary heap to insert.
+ * @priority: order of @node, at most 64 - HEAP_KEYED_SEQ_BITS bits.
+ * @node: new node to insert.
+ */
+int heap_keyed_dary_stable_insert(struct heap_keyed *keyed, uint64_t priority, void *node)
+{
+    return keyed_stable_insert(keyed, priority, node, HEAP_KEYED_WAYS);
+}
+
+/**
+ * heap_keyed_dary_delete - delete slot at index from keyed d-ary heap.
+ * @keyed: keyed d-ary heap of node.
+ * @index: index of the slot to delete.
+ */
+void *heap_keyed_dary_delete(struct heap_keyed *keyed, unsigned int index)
+{
+    return keyed_delete(keyed, index, HEAP_KEYED_WAYS);
+}
+
+static __always_inline void
+index_place(struct heap_index *index, unsigned int slot, uint32_t entry)
+{
+    index->slots[slot] = entry;
+    if (index->where)
+        index->where[entry] = slot;
+}
+
+#define INDEX_LOAD(index, slot) ((index)->slots[slot])
+#define INDEX_BEFORE(index, cmp, entrya, entryb) \
+    (heap_stats_cmp(&(index)->stats, cmp, HEAP_INDEX_ENTRY(index, entrya), HEAP_INDEX_ENTRY(index, entryb)) < 0)
+
+ARRAY_SIFT_DEFINE(index, struct heap_index, uint32_t, INDEX_LOAD, index_place, INDEX_BEFORE)
+
+static __always_inline uint32_t
+index_delete(struct heap_index *index, unsigned int slot, heap_array_cmp_t cmp)
+{
+    uint32_t entry = index->slots[slot];
+
+    if (slot != --index->count) {
+        index->slots[slot] = index->slots[index->count];
+        index_erase(index, slot, cmp, 2);
+    }
+
+    if (index->where)
+        index->where[entry] = HEAP_INDEX_NONE;
+
+    return entry;
+}
+
+/**
+ * heap_index_init - initialize an empty index heap.
+ * @index: index heap to initialize.
+ * @slots: storage for @capacity entry numbers.
+ * @where: optional slot map, one per record, or NULL.
+ * @capacity: number of records at @base.
+ * @base: first record.
+ * @size: size of one record.
+ *
+ * Each queued entry costs four bytes in @slots, plus four in @where
+ * when update and delete are needed.
+ */
+void heap_index_init(struct heap_index *index, uint32_t *slots, uint32_t *where,
+                     unsigned int capacity, const void *base, size_t size)
+{
+    unsigned int count;
+
+    index->slots = slots;
+    index->where = where;
+    index->base = base;
+    index->size = size;
+    index->count = 0;
+    index->capacity = capacity;
+    heap_stats_reset(&index->stats);
+
+    for (count = 0; where && count < capacity; ++count)
+        where[count] = HEAP_INDEX_NONE;
+}
+
+/**
+ * heap_index_insert - insert entry into index heap.
+ * @index: index heap to insert.
+ * @entry: number of the record to insert.
+ * @cmp: operator defining the record order.
+ */
+int heap_index_insert(struct heap_index *index, uint32_t entry, heap_array_cmp_t cmp)
+{
+    if (unlikely(index->count == index->capacity))
+        return -ENOSPC;
+
+    index->slots[index->count] = entry;
+    index_fixup(index, index->count++, cmp, 2);
+
+    return 0;
+}
+
+/**
+ * heap_index_update - rebalance entry after its record changed.
+ * @index: index heap with a @where map.
+ * @entry: number of the queued record.
+ * @cmp: operator defining the record order.
+ */
+void heap_index_update(struct heap_index *index, uint32_t entry, heap_array_cmp_t cmp)
+{
+    index_erase(index, index->where[entry], cmp, 2);
+}
+
+/**
+ * heap_index_delete - delete entry from index heap.
+ * @index: index heap with a @where map.
+ * @entry: number of the queued record.
+ * @cmp: operator defining the record order.
+ */
+void heap_index_delete(struct heap_index *index, uint32_t entry, heap_array_cmp_t cmp)
+{
+    index_delete(index, index->where[entry], cmp);
+}
+
+/**
+ * heap_index_pop - delete and return the top entry number.
+ * @index: index heap to pop.
+ * @cmp: operator defining the record order.
+ *
+ * Returns HEAP_INDEX_NONE if @index is empty.
+ */
+uint32_t heap_index_pop(struct heap_index *index, heap_array_cmp_t cmp)
+{
+    if (unlikely(!index->count))
+        return HEAP_INDEX_NONE;
+
+    return index_delete(index, 0, cmp);
+}
@@ -0,0 +1,301 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_ARRAY_H_
+#define _HEAP_ARRAY_H_
+
+#include "heap.h"
+#include <stdint.h>
+
+struct heap_array {
+    void **nodes;
+    unsigned int count;
+    unsigned int capacity;
+#ifdef HEAP_STATS
+    struct heap_stats stats;
+#endif
+};
+
+#define HEAP_ARRAY_STATIC(nodes, capacity) \
+    {nodes, 0, capacity}
+
+#define HEAP_ARRAY_INIT(nodes, capacity) \
+    (struct heap_array) HEAP_ARRAY_STATIC(nodes, capacity)
+
+#define HEAP_ARRAY(name, nodes, capacity) \
+    struct heap_array name = HEAP_ARRAY_INIT(nodes, capacity)
+
+#define HEAP_ARRAY_EMPTY(array) \
+    (!(array)->count)
+
+#define HEAP_ARRAY_FULL(array) \
+    ((array)->count == (array)->capacity)
+
+#define HEAP_ARRAY_COUNT(array) \
+    ((array)->count)
+
+/*
+ * Fan-out of the d-ary layout, children of a node are stored next to
+ * each other and start on a HEAP_DARY_ALIGN boundary, so that with
+ * 8-byte node pointers a whole sibling group shares one cache line.
+ */
+#ifndef HEAP_DARY_WAYS
+# define HEAP_DARY_WAYS 8
+#endif
+
+#if HEAP_DARY_WAYS != 4 && HEAP_DARY_WAYS != 8
+# error "HEAP_DARY_WAYS must be 4 or 8"
+#endif
+
+#define HEAP_DARY_ALIGN 64
+
+/**
+ * HEAP_DARY_SIZE - slots a d-ary buffer needs to hold @capacity nodes.
+ * @capacity: maximum number of nodes.
+ */
+#define HEAP_DARY_SIZE(capacity) \
+    ((capacity) + HEAP_DARY_WAYS - 1)
+
+/*
+ * Compact index heap, entries stay in a caller-provided array of
+ * fixed-size records and the heap only keeps their 32-bit numbers.
+ * @where maps an entry back to its slot for update and delete, it may
+ * be NULL when only insert and pop are used.
+ */
+struct heap_index {
+    uint32_t *slots;
+    uint32_t *where;
+    const char *base;
+    size_t size;
+    unsigned int count;
+    unsigned int capacity;
+#ifdef HEAP_STATS
+    struct heap_stats stats;
+#endif
+};
+
+#define HEAP_INDEX_NONE UINT32_MAX
+
+#define HEAP_INDEX_EMPTY(index) \
+    (!(index)->count)
+
+#define HEAP_INDEX_FULL(index) \
+    ((index)->count == (index)->capacity)
+
+#define HEAP_INDEX_COUNT(index) \
+    ((index)->count)
+
+/**
+ * HEAP_INDEX_ENTRY - get the record of entry number @entry.
+ * @index: index heap the entry belongs to.
+ * @entry: entry number.
+ */
+#define HEAP_INDEX_ENTRY(index, entry) \
+    ((void *)((index)->base + (size_t)(entry) * (index)->size))
+
+/**
+ * HEAP_INDEX_QUEUED - check whether entry is in index heap.
+ * @index: index heap with a @where map.
+ * @entry: entry number.
+ */
+#define HEAP_INDEX_QUEUED(index, entry) \
+    ((index)->where[entry] != HEAP_INDEX_NONE)
+
+/*
+ * Keyed heap, every slot carries its integer key next to the node so
+ * that sifts compare contiguous keys and never dereference the nodes.
+ * Smaller keys are closer to the top.
+ */
+struct heap_keyed_slot {
+    uint64_t key;
+    void *node;
+};
+
+struct heap_keyed {
+    struct heap_keyed_slot *slots;
+    unsigned int count;
+    unsigned int capacity;
+    uint64_t seq;
+#ifdef HEAP_STATS
+    struct heap_stats stats;
+#endif
+};
+
+#define HEAP_KEYED_STATIC(slots, capacity) \
+    {slots, 0, capacity, 0}
+
+#define HEAP_KEYED_INIT(slots, capacity) \
+    (struct heap_keyed) HEAP_KEYED_STATIC(slots, capacity)
+
+#define HEAP_KEYED(name, slots, capacity) \
+    struct heap_keyed name = HEAP_KEYED_INIT(slots, capacity)
+
+#define HEAP_KEYED_EMPTY(keyed) \
+    (!(keyed)->count)
+
+#define HEAP_KEYED_FULL(keyed) \
+    ((keyed)->count == (keyed)->capacity)
+
+#define HEAP_KEYED_COUNT(keyed) \
+    ((keyed)->count)
+
+/*
+ * Stable keyed mode, the low HEAP_KEYED_SEQ_BITS of a key count the
+ * insertions and the priority sits above them. Equal priorities then
+ * leave in insertion order with the same single 64-bit compare.
+ */
+#ifndef HEAP_KEYED_SEQ_BITS
+# define HEAP_KEYED_SEQ_BITS 32
+#endif
+
+#define HEAP_KEYED_SEQ_MASK \
+    ((UINT64_C(1) << HEAP_KEYED_SEQ_BITS) - 1)
+
+/**
+ * HEAP_KEYED_PRIORITY - get the priority of a stable key.
+ * @key: key of a slot inserted in stable mode.
+ */
+#define HEAP_KEYED_PRIORITY(key) \
+    ((key) >> HEAP_KEYED_SEQ_BITS)
+
+/*
+ * Fan-out of the keyed d-ary layout, four 16-byte slots fill exactly
+ * one HEAP_DARY_ALIGN line.
+ */
+#define HEAP_KEYED_WAYS 4
+
+/**
+ * HEAP_KEYED_DARY_SIZE - slots a keyed d-ary buffer needs to hold @capacity nodes.
+ * @capacity: maximum number of nodes.
+ */
+#define HEAP_KEYED_DARY_SIZE(capacity) \
+    ((capacity) + HEAP_KEYED_WAYS - 1)
+
+typedef long (*heap_array_cmp_t)(const void *nodea, const void *nodeb);
+extern void heap_array_fixup(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp);
+extern void heap_array_erase(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp);
+extern int heap_array_insert(struct heap_array *array, void *node, heap_array_cmp_t cmp);
+extern void *heap_array_delete(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp);
+
+extern void heap_dary_init(struct heap_array *array, void **buffer, unsigned int size);
+extern void heap_dary_fixup(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp);
+extern void heap_dary_erase(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp);
+extern int heap_dary_insert(struct heap_array *array, void *node, heap_array_cmp_t cmp);
+extern void *heap_dary_delete(struct heap_array *array, unsigned int index, heap_array_cmp_t cmp);
+
+extern void heap_index_init(struct heap_index *index, uint32_t *slots, uint32_t *where,
+                            unsigned int capacity, const void *base, size_t size);
+extern int heap_index_insert(struct heap_index *index, uint32_t entry, heap_array_cmp_t cmp);
+extern void heap_index_update(struct heap_index *index, uint32_t entry, heap_array_cmp_t cmp);
+extern void heap_index_delete(struct heap_index *index, uint32_t entry, heap_array_cmp_t cmp);
+extern uint32_t heap_index_pop(struct heap_index *index, heap_array_cmp_t cmp);
+
+extern void heap_keyed_fixup(struct heap_keyed *keyed, unsigned int index);
+extern void heap_keyed_erase(struct heap_keyed *keyed, unsigned int index);
+extern int heap_keyed_insert(struct heap_keyed *keyed, uint64_t key, void *node);
+extern int heap_keyed_stable_insert(struct heap_keyed *keyed, uint64_t priority, void *node);
+extern void *heap_keyed_delete(struct heap_keyed *keyed, unsigned int index);
+
+extern void heap_keyed_dary_init(struct heap_keyed *keyed, struct heap_keyed_slot *buffer, unsigned int size);
+extern void heap_keyed_dary_fixup(struct heap_keyed *keyed, unsigned int index);
+extern void heap_keyed_dary_erase(struct heap_keyed *keyed, unsigned int index);
+extern int heap_keyed_dary_insert(struct heap_keyed *keyed, uint64_t key, void *node);
+extern int heap_keyed_dary_stable_insert(struct heap_keyed *keyed, uint64_t priority, void *node);
+extern void *heap_keyed_dary_delete(struct heap_keyed *keyed, unsigned int index);
+
+/**
+ * heap_keyed_peek - get the top slot of keyed heap.
+ * @keyed: keyed heap to peek.
+ */
+static inline struct heap_keyed_slot *heap_keyed_peek(const struct heap_keyed *keyed)
+{
+    return keyed->count ? &keyed->slots[0] : NULL;
+}
+
+/**
+ * heap_keyed_pop - delete and return the top node of keyed heap.
+ * @keyed: keyed heap to pop.
+ */
+static inline void *heap_keyed_pop(struct heap_keyed *keyed)
+{
+    return keyed->count ? heap_keyed_delete(keyed, 0) : NULL;
+}
+
+/**
+ * heap_keyed_dary_pop - delete and return the top node of keyed d-ary heap.
+ * @keyed: keyed d-ary heap to pop.
+ */
+static inline void *heap_keyed_dary_pop(struct heap_keyed *keyed)
+{
+    return keyed->count ? heap_keyed_dary_delete(keyed, 0) : NULL;
+}
+
+/**
+ * heap_index_peek - get the top entry number of index heap.
+ * @index: index heap to peek.
+ *
+ * Returns HEAP_INDEX_NONE if @index is empty.
+ */
+static inline uint32_t heap_index_peek(const struct heap_index *index)
+{
+    return index->count ? index->slots[0] : HEAP_INDEX_NONE;
+}
+
+/**
+ * heap_array_peek - get the top node of array heap.
+ * @array: array heap to peek.
+ */
+static inline void *heap_array_peek(const struct heap_array *array)
+{
+    return array->count ? array->nodes[0] : NULL;
+}
+
+/**
+ * heap_array_pop - delete and return the top node of array heap.
+ * @array: array heap to pop.
+ * @cmp: operator defining the node order.
+ */
+static inline void *heap_array_pop(struct heap_array *array, heap_array_cmp_t cmp)
+{
+    return array->count ? heap_array_delete(array, 0, cmp) : NULL;
+}
+
+/**
+ * heap_dary_pop - delete and return the top node of d-ary heap.
+ * @array: d-ary heap to pop.
+ * @cmp: operator defining the node order.
+ */
+static inline void *heap_dary_pop(struct heap_array *array, heap_array_cmp_t cmp)
+{
+    return array->count ? heap_dary_delete(array, 0, cmp) : NULL;
+}
+
+/**
+ * heap_array_for_each - levelorder iterate over an array heap.
+ * @pos: the type * to use as a loop cursor.
+ * @index: unsigned int to hold the current index.
+ * @array: the array heap to iterate.
+ */
+#define heap_array_for_each(pos, index, array) \
+    for (index = 0; index < (array)->count && \
+         ((pos = (array)->nodes[index]), 1); ++index)
+
+/**
+ * heap_array_for_each_from - levelorder iterate over an array heap from the current point.
+ * @pos: the type * to use as a loop cursor.
+ * @index: unsigned int holding the current index.
+ * @array: the array heap to iterate.
+ */
+#define heap_array_for_each_from(pos, index, array) \
+    for (; index < (array)->count && \
+         ((pos = (array)->nodes[index]), 1); ++index)
+
+/**
+ * heap_array_for_each_continue - continue levelorder iteration over an array heap.
+ * @pos: the type * to use as a loop cursor.
+ * @index: unsigned int holding the current index.
+ * @array: the array heap to iterate.
+ */
+#define heap_array_for_each_continue(pos, index, array) \
+    for (++index; index < (array)->count && \
+         ((pos = (array)->nodes[index]), 1); ++index)
+
+#endif  /* _HEAP_ARRAY_H_ */
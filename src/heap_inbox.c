@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_inbox.h"
+
+/**
+ * heap_inbox_drain - move every queued node into heap.
+ * @inbox: inbox to drain.
+ * @root: heap root owned by the calling thread.
+ * @cmp: operator defining the node order.
+ *
+ * The list is detached with a single exchange, so producers keep pushing
+ * while it is inserted. Returns the number of drained nodes.
+ */
+unsigned int heap_inbox_drain(struct heap_inbox *inbox, struct heap_root *root, heap_cmp_t cmp)
+{
+    struct heap_node *nodes[HEAP_INBOX_BATCH];
+    struct heap_node *node, *next;
+    unsigned int count = 0, total = 0;
+
+    if (HEAP_INBOX_EMPTY(inbox))
+        return 0;
+
+    node = __atomic_exchange_n(&inbox->head, NULL, __ATOMIC_ACQUIRE);
+    for (; node; node = next) {
+        next = node->right;
+        nodes[count++] = node;
+        if (count == HEAP_INBOX_BATCH) {
+            heap_insert_batch(root, nodes, count, cmp);
+            total += count;
+            count = 0;
+        }
+    }
+
+    heap_insert_batch(root, nodes, count, cmp);
+    return total + count;
+}
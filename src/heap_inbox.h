@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_INBOX_H_
+#define _HEAP_INBOX_H_
+
+#include "heap.h"
+
+#define HEAP_INBOX_ALIGN 64
+
+/*
+ * Multi-producer single-consumer insertion buffer in front of a heap.
+ * Producers push nodes lock-free, chained through @right, and the owner
+ * of the heap drains the whole list in batches. Give each producer its
+ * own inbox to keep them off each other's cache line.
+ */
+struct heap_inbox {
+    struct heap_node *head;
+} __attribute__((aligned(HEAP_INBOX_ALIGN)));
+
+#define HEAP_INBOX_STATIC \
+    {NULL}
+
+#define HEAP_INBOX_INIT \
+    (struct heap_inbox) HEAP_INBOX_STATIC
+
+#define HEAP_INBOX(name) \
+    struct heap_inbox name = HEAP_INBOX_INIT
+
+#define HEAP_INBOX_EMPTY(inbox) \
+    (__atomic_load_n(&(inbox)->head, __ATOMIC_RELAXED) == NULL)
+
+/* Upper bound of nodes handed to heap_insert_batch() at once */
+#define HEAP_INBOX_BATCH 64
+
+extern unsigned int heap_inbox_drain(struct heap_inbox *inbox, struct heap_root *root, heap_cmp_t cmp);
+
+/**
+ * heap_inbox_push - queue node for insertion, safe from any thread.
+ * @inbox: inbox to queue into.
+ * @node: new node to insert.
+ */
+static inline void heap_inbox_push(struct heap_inbox *inbox, struct heap_node *node)
+{
+    struct heap_node *head = __atomic_load_n(&inbox->head, __ATOMIC_RELAXED);
+
+    do
+        node->right = head;
+    while (!__atomic_compare_exchange_n(&inbox->head, &head, node, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+#endif  /* _HEAP_INBOX_H_ */
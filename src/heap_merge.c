@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_merge.h"
+#include <unistd.h>
+#include <sys/mman.h>
+
+static __always_inline bool
+merge_fill(struct heap_merge_cursor *cursor)
+{
+    while (cursor->pos == cursor->end)
+        if (!cursor->refill || !cursor->refill(cursor))
+            return false;
+
+    return true;
+}
+
+/**
+ * heap_merge_add - add a sorted run to k-way merge.
+ * @merge: merge to add to.
+ * @cursor: cursor of the run, its records are @merge->size bytes.
+ * @cmp: operator comparing the current records of two cursors.
+ *
+ * Returns -ENODATA, leaving @merge untouched, if the run is empty.
+ */
+int heap_merge_add(struct heap_merge *merge, struct heap_merge_cursor *cursor, heap_cmp_t cmp)
+{
+    if (!merge_fill(cursor))
+        return -ENODATA;
+
+    heap_insert(&merge->root, &cursor->node, cmp);
+    return 0;
+}
+
+/**
+ * heap_merge_next - get the next record in merged order.
+ * @merge: merge to read from.
+ * @cmp: operator comparing the current records of two cursors.
+ *
+ * The returned record stays valid until the next call. The cursor it
+ * came from is advanced lazily on that call and sunk back in place with
+ * a single sift-down from the top, instead of a delete and an insert.
+ * Returns NULL once every run is exhausted.
+ */
+const void *heap_merge_next(struct heap_merge *merge, heap_cmp_t cmp)
+{
+    struct heap_merge_cursor *cursor = merge->last;
+
+    if (cursor) {
+        cursor->pos += merge->size;
+        if (merge_fill(cursor))
+            heap_increase_key(&merge->root, &cursor->node, cmp);
+        else
+            heap_delete(&merge->root, &cursor->node, cmp);
+    }
+
+    if (!merge->root.node) {
+        merge->last = NULL;
+        return NULL;
+    }
+
+    cursor = merge->last = heap_to_cursor(merge->root.node);
+    return cursor->pos;
+}
+
+static bool merge_map_refill(struct heap_merge_cursor *cursor)
+{
+    struct heap_merge_map *map = heap_entry(cursor, struct heap_merge_map, cursor);
+    size_t window, page = sysconf(_SC_PAGESIZE);
+
+    /* drop the window just consumed, keeping the page still shared */
+    if (map->offset > map->start && (window = (map->offset & ~(page - 1))) > map->start)
+        madvise(map->map + map->start, window - map->start, MADV_DONTNEED);
+    map->start = map->offset & ~(page - 1);
+
+    if (map->offset >= map->length)
+        return false;
+
+    window = map->length - map->offset;
+    if (window > map->window)
+        window = map->window;
+
+    cursor->pos = map->map + map->offset;
+    cursor->end = cursor->pos + window;
+    map->offset += window;
+
+    if (map->offset < map->length)
+        madvise(map->map + (map->offset & ~(page - 1)),
+                map->length - map->offset < map->window ?
+                map->length - map->offset : map->window, MADV_WILLNEED);
+
+    return true;
+}
+
+/**
+ * heap_merge_map_init - set up a cursor over a run stored in a file.
+ * @map: mapped cursor to set up.
+ * @fd: file opened for reading.
+ * @offset: byte offset of the run in @fd.
+ * @length: bytes of the run, a multiple of the record size.
+ * @window: bytes per refill, a multiple of the record size, or zero
+ *          for HEAP_MERGE_WINDOW.
+ */
+int heap_merge_map_init(struct heap_merge_map *map, int fd, off_t offset, size_t length, size_t window)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    off_t base = offset & ~((off_t)page - 1);
+    void *addr;
+
+    map->cursor.pos = map->cursor.end = NULL;
+    map->cursor.refill = merge_map_refill;
+    map->window = window ?: HEAP_MERGE_WINDOW;
+    map->offset = map->start = offset - base;
+    map->length = map->offset + length;
+    map->map = NULL;
+
+    if (!length)
+        return 0;
+
+    addr = mmap(NULL, map->length, PROT_READ, MAP_PRIVATE, fd, base);
+    if (addr == MAP_FAILED)
+        return -errno;
+
+    madvise(addr, map->length, MADV_SEQUENTIAL);
+    map->map = addr;
+
+    return 0;
+}
+
+/**
+ * heap_merge_map_release - unmap a mapped cursor.
+ * @map: mapped cursor to release, must no longer be in a merge.
+ */
+void heap_merge_map_release(struct heap_merge_map *map)
+{
+    if (map->map)
+        munmap(map->map, map->length);
+    map->map = NULL;
+}
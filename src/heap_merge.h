@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_MERGE_H_
+#define _HEAP_MERGE_H_
+
+#include "heap.h"
+#include <sys/types.h>
+
+/* Default bytes of a mapped run handed out per refill */
+#ifndef HEAP_MERGE_WINDOW
+# define HEAP_MERGE_WINDOW (1UL << 20)
+#endif
+
+struct heap_merge_cursor;
+typedef bool (*heap_merge_refill_t)(struct heap_merge_cursor *cursor);
+
+/*
+ * One sorted input run. Records between @pos and @end are buffered,
+ * @refill is asked for the next batch once they are consumed and
+ * returns false at the end of the run. @refill may be NULL for a run
+ * that is buffered completely.
+ */
+struct heap_merge_cursor {
+    struct heap_node node;
+    const char *pos;
+    const char *end;
+    heap_merge_refill_t refill;
+};
+
+struct heap_merge {
+    struct heap_root root;
+    struct heap_merge_cursor *last;
+    size_t size;
+};
+
+/*
+ * Cursor over a read-only mapping of a run in a file, the mapping is
+ * consumed in @window sized batches and pages behind the cursor are
+ * dropped as it moves on.
+ */
+struct heap_merge_map {
+    struct heap_merge_cursor cursor;
+    char *map;
+    size_t length;
+    size_t offset;
+    size_t start;
+    size_t window;
+};
+
+#define HEAP_MERGE_STATIC(size) \
+    {HEAP_STATIC, NULL, size}
+
+#define HEAP_MERGE_INIT(size) \
+    (struct heap_merge) HEAP_MERGE_STATIC(size)
+
+#define HEAP_MERGE(name, size) \
+    struct heap_merge name = HEAP_MERGE_INIT(size)
+
+#define HEAP_MERGE_EMPTY(merge) \
+    (!(merge)->root.node)
+
+/**
+ * heap_to_cursor - get the cursor of an intrusive node.
+ * @ptr: the &struct heap_node of a cursor.
+ */
+#define heap_to_cursor(ptr) \
+    heap_entry(ptr, struct heap_merge_cursor, node)
+
+/**
+ * HEAP_MERGE_RECORD - get the current record of cursor.
+ * @cursor: the &struct heap_merge_cursor to read.
+ */
+#define HEAP_MERGE_RECORD(cursor) \
+    ((const void *)(cursor)->pos)
+
+extern int heap_merge_add(struct heap_merge *merge, struct heap_merge_cursor *cursor, heap_cmp_t cmp);
+extern const void *heap_merge_next(struct heap_merge *merge, heap_cmp_t cmp);
+extern int heap_merge_map_init(struct heap_merge_map *map, int fd, off_t offset, size_t length, size_t window);
+extern void heap_merge_map_release(struct heap_merge_map *map);
+
+/**
+ * heap_merge_buffer - set up a cursor over an in-memory run.
+ * @cursor: cursor to set up.
+ * @base: first record of the run.
+ * @length: bytes of the run.
+ */
+static inline void heap_merge_buffer(struct heap_merge_cursor *cursor, const void *base, size_t length)
+{
+    cursor->pos = base;
+    cursor->end = (const char *)base + length;
+    cursor->refill = NULL;
+}
+
+#endif  /* _HEAP_MERGE_H_ */
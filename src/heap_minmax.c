@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_minmax.h"
+
+/*
+ * minmax_before - whether @nodea belongs above @nodeb on a level,
+ * min levels keep the smaller node on top and max levels the larger.
+ */
+static __always_inline bool
+minmax_before(struct heap_root *root, const struct heap_node *nodea,
+              const struct heap_node *nodeb, bool max, heap_cmp_t cmp)
+{
+    long retval = heap_stats_cmp(&root->stats, cmp, nodea, nodeb);
+    return max ? retval > 0 : retval < 0;
+}
+
+/*
+ * minmax_exchange - exchange the position of two nodes that are not
+ * parent and child of each other, here a node and its grandparent.
+ */
+static void minmax_exchange(struct heap_root *root, struct heap_node *nodea, struct heap_node *nodeb)
+{
+    struct heap_node **linka, **linkb;
+    struct heap_node shadow = *nodea;
+
+    heap_stats_add(&root->stats, swaps, 1);
+    linka = heap_hole_link(root, nodea);
+    linkb = heap_hole_link(root, nodeb);
+    *linka = nodeb;
+    *linkb = nodea;
+
+    *nodea = *nodeb;
+    *nodeb = shadow;
+
+    if (nodea->left)
+        nodea->left->parent = nodea;
+    if (nodea->right)
+        nodea->right->parent = nodea;
+    if (nodeb->left)
+        nodeb->left->parent = nodeb;
+    if (nodeb->right)
+        nodeb->right->parent = nodeb;
+}
+
+static __always_inline struct heap_node *
+minmax_pick(struct heap_root *root, struct heap_node *best,
+            struct heap_node *node, bool max, heap_cmp_t cmp)
+{
+    if (node && minmax_before(root, node, best, max, cmp))
+        return node;
+    return best;
+}
+
+static void minmax_trickle(struct heap_root *root, struct heap_node *node, bool max, heap_cmp_t cmp)
+{
+    struct heap_node *best, *child, *parent;
+
+    heap_stats_add(&root->stats, fixdowns, 1);
+    while ((child = node->left)) {
+        heap_stats_add(&root->stats, downs, 1);
+
+        /* the best of up to two children and four grandchildren */
+        best = child;
+        best = minmax_pick(root, best, child->left, max, cmp);
+        best = minmax_pick(root, best, child->right, max, cmp);
+        if ((child = node->right)) {
+            best = minmax_pick(root, best, child, max, cmp);
+            best = minmax_pick(root, best, child->left, max, cmp);
+            best = minmax_pick(root, best, child->right, max, cmp);
+        }
+
+        if (!minmax_before(root, best, node, max, cmp))
+            break;
+
+        if (best->parent == node) {
+            heap_parent_swap(root, node, best);
+            break;
+        }
+
+        /* node moves two levels down, past a level of the other order */
+        minmax_exchange(root, node, best);
+        parent = node->parent;
+        if (minmax_before(root, parent, node, max, cmp)) {
+            heap_parent_swap(root, parent, node);
+            node = parent;
+        }
+    }
+}
+
+static void minmax_bubble(struct heap_root *root, struct heap_node *node, bool max, heap_cmp_t cmp)
+{
+    struct heap_node *gparent;
+
+    heap_stats_add(&root->stats, fixups, 1);
+    while (node->parent && (gparent = node->parent->parent)) {
+        if (!minmax_before(root, node, gparent, max, cmp))
+            break;
+        heap_stats_add(&root->stats, ups, 1);
+        minmax_exchange(root, gparent, node);
+    }
+}
+
+/**
+ * heap_minmax_insert - insert node into min-max heap.
+ * @root: min-max heap to insert into.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+void heap_minmax_insert(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *parent, **link;
+    bool max;
+
+    link = heap_parent(root, &parent, node);
+    heap_link(root, parent, link, node);
+
+    /* root->count is the level order index of node */
+    max = (31 - __builtin_clz(root->count)) & 1;
+    if (parent && minmax_before(root, node, parent, !max, cmp)) {
+        heap_parent_swap(root, parent, node);
+        max = !max;
+    }
+
+    minmax_bubble(root, node, max, cmp);
+}
+
+/**
+ * heap_minmax_pop_min - remove the first node of min-max heap.
+ * @root: min-max heap to pop from.
+ * @cmp: operator defining the node order.
+ */
+struct heap_node *heap_minmax_pop_min(struct heap_root *root, heap_cmp_t cmp)
+{
+    struct heap_node *node, *rebalance;
+
+    if (!(node = root->node))
+        return NULL;
+
+    if ((rebalance = heap_remove(root, node)))
+        minmax_trickle(root, rebalance, false, cmp);
+
+    return node;
+}
+
+/**
+ * heap_minmax_pop_max - remove the last node of min-max heap.
+ * @root: min-max heap to pop from.
+ * @cmp: operator defining the node order.
+ */
+struct heap_node *heap_minmax_pop_max(struct heap_root *root, heap_cmp_t cmp)
+{
+    struct heap_node *node, *rebalance;
+
+    if (!(node = heap_minmax_peek_max(root, cmp)))
+        return NULL;
+
+    /* the root can only be the maximum when it is the only node */
+    if ((rebalance = heap_remove(root, node)))
+        minmax_trickle(root, rebalance, true, cmp);
+
+    return node;
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_MINMAX_H_
+#define _HEAP_MINMAX_H_
+
+#include "heap.h"
+
+/*
+ * Min-max heap over the plain &struct heap_root shape. Nodes on even
+ * levels (the root is level zero) are ordered before all of their
+ * descendants, nodes on odd levels after them, so both ends of the
+ * queue sit within the top two levels.
+ */
+
+extern void heap_minmax_insert(struct heap_root *root, struct heap_node *node, heap_cmp_t cmp);
+extern struct heap_node *heap_minmax_pop_min(struct heap_root *root, heap_cmp_t cmp);
+extern struct heap_node *heap_minmax_pop_max(struct heap_root *root, heap_cmp_t cmp);
+
+/**
+ * heap_minmax_peek_min - get the first node of min-max heap.
+ * @root: min-max heap to peek.
+ */
+static inline struct heap_node *heap_minmax_peek_min(struct heap_root *root)
+{
+    return root->node;
+}
+
+/**
+ * heap_minmax_peek_max - get the last node of min-max heap.
+ * @root: min-max heap to peek.
+ * @cmp: operator defining the node order.
+ */
+static inline struct heap_node *heap_minmax_peek_max(struct heap_root *root, heap_cmp_t cmp)
+{
+    struct heap_node *node = root->node;
+
+    if (!node || !node->left)
+        return node;
+
+    if (node->right && cmp(node->right, node->left) > 0)
+        return node->right;
+
+    return node->left;
+}
+
+#endif  /* _HEAP_MINMAX_H_ */
@@ -0,0 +1,146 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_pairing.h"
+
+static __always_inline struct heap_node *
+pairing_link(struct heap_pairing *pairing, struct heap_node *nodea,
+             struct heap_node *nodeb, heap_cmp_t cmp)
+{
+    struct heap_node *tmp;
+
+    if (!nodea)
+        return nodeb;
+    if (!nodeb)
+        return nodea;
+
+    heap_stats_add(&pairing->stats, swaps, 1);
+    if (heap_stats_cmp(&pairing->stats, cmp, nodeb, nodea) < 0) {
+        tmp = nodea;
+        nodea = nodeb;
+        nodeb = tmp;
+    }
+
+    /* nodeb becomes the first child of nodea */
+    if ((nodeb->right = nodea->left))
+        nodea->left->parent = nodeb;
+    nodea->left = nodeb;
+    nodeb->parent = nodea;
+
+    return nodea;
+}
+
+static __always_inline void
+pairing_cut(struct heap_node *node)
+{
+    struct heap_node *prev = node->parent;
+
+    if (prev->left == node)
+        prev->left = node->right;
+    else /* prev->right == node */
+        prev->right = node->right;
+
+    if (node->right)
+        node->right->parent = prev;
+
+    node->parent = node->right = NULL;
+}
+
+static struct heap_node *
+pairing_merge(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *nodea, *nodeb, *stack = NULL;
+
+    /* first pass: link siblings in pairs, stacking the results */
+    while (node) {
+        nodea = node;
+        nodeb = nodea->right;
+        node = nodeb ? nodeb->right : NULL;
+
+        nodea->parent = nodea->right = NULL;
+        if (nodeb) {
+            nodeb->parent = nodeb->right = NULL;
+            nodea = pairing_link(pairing, nodea, nodeb, cmp);
+        }
+
+        nodea->right = stack;
+        stack = nodea;
+    }
+
+    /* second pass: link the pairs from the last one backward */
+    while (stack) {
+        nodea = stack;
+        stack = nodea->right;
+        nodea->right = NULL;
+        node = pairing_link(pairing, node, nodea, cmp);
+    }
+
+    return node;
+}
+
+/**
+ * heap_pairing_insert - insert new node into pairing heap.
+ * @pairing: pairing heap to insert.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+void heap_pairing_insert(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp)
+{
+    node->parent = node->left = node->right = NULL;
+    pairing->node = pairing_link(pairing, pairing->node, node, cmp);
+    pairing->count++;
+}
+
+/**
+ * heap_pairing_delete - delete node from pairing heap.
+ * @pairing: pairing heap of node.
+ * @node: node to delete.
+ * @cmp: operator defining the node order.
+ */
+void heap_pairing_delete(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_node *children;
+
+    if (node == pairing->node)
+        pairing->node = pairing_merge(pairing, node->left, cmp);
+    else {
+        pairing_cut(node);
+        children = pairing_merge(pairing, node->left, cmp);
+        pairing->node = pairing_link(pairing, pairing->node, children, cmp);
+    }
+
+    pairing->count--;
+    node->left = POISON_HPNODE1;
+    node->right = POISON_HPNODE2;
+    node->parent = POISON_HPNODE3;
+}
+
+/**
+ * heap_pairing_fixup - balance after node moves toward the top.
+ * @pairing: pairing heap of node.
+ * @node: node whose order has decreased.
+ * @cmp: operator defining the node order.
+ */
+void heap_pairing_fixup(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp)
+{
+    if (node == pairing->node)
+        return;
+
+    pairing_cut(node);
+    pairing->node = pairing_link(pairing, pairing->node, node, cmp);
+}
+
+/**
+ * heap_pairing_meld - move every node of @src into @dst.
+ * @dst: pairing heap to meld into.
+ * @src: pairing heap to meld from, left empty.
+ * @cmp: operator defining the node order.
+ */
+void heap_pairing_meld(struct heap_pairing *dst, struct heap_pairing *src, heap_cmp_t cmp)
+{
+    dst->node = pairing_link(dst, dst->node, src->node, cmp);
+    dst->count += src->count;
+    *src = HEAP_PAIRING_INIT;
+}
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_PAIRING_H_
+#define _HEAP_PAIRING_H_
+
+#include "heap.h"
+
+/*
+ * Pairing heap on top of struct heap_node:
+ *   @left: first child.
+ *   @right: next sibling.
+ *   @parent: previous sibling, or parent for the first child.
+ */
+struct heap_pairing {
+    struct heap_node *node;
+    unsigned int count;
+#ifdef HEAP_STATS
+    struct heap_stats stats;
+#endif
+};
+
+#define HEAP_PAIRING_STATIC \
+    {NULL, 0}
+
+#define HEAP_PAIRING_INIT \
+    (struct heap_pairing) HEAP_PAIRING_STATIC
+
+#define HEAP_PAIRING(name) \
+    struct heap_pairing name = HEAP_PAIRING_INIT
+
+#define HEAP_PAIRING_EMPTY(pairing) \
+    ((pairing)->node == NULL)
+
+#define HEAP_PAIRING_COUNT(pairing) \
+    ((pairing)->count)
+
+extern void heap_pairing_insert(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp);
+extern void heap_pairing_delete(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp);
+extern void heap_pairing_fixup(struct heap_pairing *pairing, struct heap_node *node, heap_cmp_t cmp);
+extern void heap_pairing_meld(struct heap_pairing *dst, struct heap_pairing *src, heap_cmp_t cmp);
+
+/**
+ * heap_pairing_peek - get the top node of pairing heap.
+ * @pairing: pairing heap to peek.
+ */
+static inline struct heap_node *heap_pairing_peek(const struct heap_pairing *pairing)
+{
+    return pairing->node;
+}
+
+/**
+ * heap_pairing_pop - delete and return the top node of pairing heap.
+ * @pairing: pairing heap to pop.
+ * @cmp: operator defining the node order.
+ */
+static inline struct heap_node *heap_pairing_pop(struct heap_pairing *pairing, heap_cmp_t cmp)
+{
+    struct heap_node *node = pairing->node;
+
+    if (node)
+        heap_pairing_delete(pairing, node, cmp);
+
+    return node;
+}
+
+#endif  /* _HEAP_PAIRING_H_ */
@@ -0,0 +1,255 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_parallel.h"
+#include <pthread.h>
+
+struct parallel_work {
+    pthread_t thread;
+    bool spawned;
+    unsigned int index;
+    struct heap_root *root;
+    struct heap_root local;
+    struct heap_node **nodes;
+    unsigned int count;
+    unsigned int levels;
+    unsigned long start;
+    unsigned long end;
+    heap_cmp_t cmp;
+    heap_release_t release;
+    heap_scan_t scan;
+    void *pdata;
+};
+
+static unsigned int parallel_threads(unsigned int count, unsigned int threads)
+{
+    if (threads > HEAP_PARALLEL_THREADS)
+        threads = HEAP_PARALLEL_THREADS;
+    if (threads > count / HEAP_PARALLEL_MIN)
+        threads = count / HEAP_PARALLEL_MIN;
+    return threads;
+}
+
+static inline unsigned int parallel_split(unsigned int threads)
+{
+    /* smallest power of two subtrees covering every worker */
+    return 1U << (32 - __builtin_clz(threads - 1));
+}
+
+static void parallel_run(struct parallel_work *works, unsigned int threads, void *(*func)(void *))
+{
+    unsigned int index;
+
+    for (index = 1; index < threads; ++index)
+        works[index].spawned = !pthread_create(&works[index].thread, NULL, func, &works[index]);
+
+    func(&works[0]);
+
+    /* a worker that could not be spawned is run by the caller instead */
+    for (index = 1; index < threads; ++index) {
+        if (works[index].spawned)
+            pthread_join(works[index].thread, NULL);
+        else
+            func(&works[index]);
+    }
+}
+
+static void parallel_slice(struct parallel_work *works, unsigned int threads,
+                           unsigned long base, unsigned long total)
+{
+    unsigned int index;
+
+    for (index = 0; index < threads; ++index) {
+        works[index].start = base + total * index / threads;
+        works[index].end = base + total * (index + 1) / threads;
+    }
+}
+
+static void *build_heapify(void *pdata)
+{
+    struct parallel_work *work = pdata;
+    unsigned long lo, hi, inner = work->count >> 1;
+    unsigned int level = work->levels + 1;
+
+    /* sink the subtrees bottom-up, one level of all of them at a time */
+    while (level--) {
+        lo = ((work->start + 1) << level) - 1;
+        hi = ((work->end + 1) << level) - 1;
+        if (hi > inner)
+            hi = inner;
+        while (hi > lo)
+            heap_build_siftdown(&work->local, work->nodes, work->count, --hi, work->cmp);
+    }
+
+    return NULL;
+}
+
+static void *build_link(void *pdata)
+{
+    struct parallel_work *work = pdata;
+
+    heap_build_link(work->nodes, work->count, work->start, work->end);
+    return NULL;
+}
+
+/**
+ * heap_build_parallel - build heap from unordered nodes with several threads.
+ * @root: heap root to build, expected to be empty.
+ * @nodes: array of nodes to add, reordered in place.
+ * @count: number of @nodes.
+ * @cmp: operator defining the node order.
+ * @threads: number of workers to use at most.
+ *
+ * Each worker heapifies its subtrees below the split depth, then the
+ * few nodes above it are sunk by the caller and all workers link their
+ * share of the array. Falls back to heap_build() for small inputs.
+ */
+void heap_build_parallel(struct heap_root *root, struct heap_node **nodes, unsigned int count,
+                         heap_cmp_t cmp, unsigned int threads)
+{
+    struct parallel_work works[HEAP_PARALLEL_THREADS];
+    unsigned int index, split, levels;
+
+    if (root->node || (threads = parallel_threads(count, threads)) < 2) {
+        heap_build(root, nodes, count, cmp);
+        return;
+    }
+
+    /* levels of each subtree below its root at the split depth */
+    split = parallel_split(threads);
+    levels = 31 - __builtin_clz(count) - __builtin_ctz(split);
+
+    for (index = 0; index < threads; ++index) {
+        works[index].local = HEAP_INIT;
+        works[index].nodes = nodes;
+        works[index].count = count;
+        works[index].levels = levels;
+        works[index].cmp = cmp;
+    }
+
+    parallel_slice(works, threads, split - 1, split);
+    parallel_run(works, threads, build_heapify);
+
+    for (index = split - 1; index--;)
+        heap_build_siftdown(root, nodes, count, index, cmp);
+
+    parallel_slice(works, threads, 0, count);
+    parallel_run(works, threads, build_link);
+
+    for (index = 0; index < threads; ++index) {
+        heap_stats_add(&root->stats, cmps, works[index].local.stats.cmps);
+        heap_stats_add(&root->stats, swaps, works[index].local.stats.swaps);
+        heap_stats_add(&root->stats, fixdowns, works[index].local.stats.fixdowns);
+        heap_stats_add(&root->stats, downs, works[index].local.stats.downs);
+    }
+
+    root->node = nodes[0];
+    root->count = count;
+    heap_stats_depth(&root->stats, 64U - __builtin_clzll(count));
+}
+
+static void *destroy_subtree(void *pdata)
+{
+    struct parallel_work *work = pdata;
+    struct heap_node *subtree, *node, *next;
+    unsigned long index;
+
+    HEAP_ROOT(shadow);
+
+    for (index = work->start; index < work->end; ++index) {
+        shadow.node = subtree = work->nodes[index];
+        for (node = heap_post_first(&shadow); node; node = next) {
+            /* never climb above the subtree, its parent is not ours */
+            next = node == subtree ? NULL : heap_post_next(node);
+            work->release(node, work->pdata);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * heap_destroy_parallel - release every node of heaptree with several threads.
+ * @root: heaptree to destroy.
+ * @release: called once per node, children before parents.
+ * @pdata: private data of @release.
+ * @threads: number of workers to use at most.
+ *
+ * Nodes above the split depth are released by the caller once every
+ * subtree is gone. Falls back to heap_destroy() for small heaps.
+ */
+void heap_destroy_parallel(struct heap_root *root, heap_release_t release, void *pdata, unsigned int threads)
+{
+    struct parallel_work works[HEAP_PARALLEL_THREADS];
+    struct heap_node *tops[HEAP_PARALLEL_THREADS * 2], *node;
+    unsigned int index, split;
+
+    if ((threads = parallel_threads(root->count, threads)) < 2) {
+        heap_destroy(root, release, pdata);
+        return;
+    }
+
+    /* HEAP_PARALLEL_MIN keeps the levels down to the split depth complete */
+    split = parallel_split(threads);
+    for (node = root->node, index = 1; index < split << 1; ++index) {
+        tops[index - 1] = node;
+        node = heap_next(root, node, index);
+    }
+
+    for (index = 0; index < threads; ++index) {
+        works[index].nodes = tops;
+        works[index].release = release;
+        works[index].pdata = pdata;
+    }
+
+    parallel_slice(works, threads, split - 1, split);
+    parallel_run(works, threads, destroy_subtree);
+
+    for (index = split - 1; index--;)
+        release(tops[index], pdata);
+
+    heap_clear(root);
+}
+
+static void *scan_range(void *pdata)
+{
+    struct parallel_work *work = pdata;
+    struct heap_node *node;
+    unsigned long index;
+
+    heap_for_each_range(node, &index, work->root, work->start, work->end)
+        work->scan(node, work->index, work->pdata);
+
+    return NULL;
+}
+
+/**
+ * heap_scan_parallel - visit every node of heaptree with several threads.
+ * @root: heaptree to scan, must not be modified meanwhile.
+ * @scan: called once per node with the index of its worker.
+ * @pdata: private data of @scan.
+ * @threads: number of workers to use at most.
+ *
+ * Workers walk equal level order slices rather than whole subtrees, so
+ * the split stays balanced for any number of workers.
+ */
+void heap_scan_parallel(struct heap_root *root, heap_scan_t scan, void *pdata, unsigned int threads)
+{
+    struct parallel_work works[HEAP_PARALLEL_THREADS];
+    unsigned int index;
+
+    if ((threads = parallel_threads(root->count, threads)) < 1)
+        threads = 1;
+
+    for (index = 0; index < threads; ++index) {
+        works[index].index = index;
+        works[index].root = root;
+        works[index].scan = scan;
+        works[index].pdata = pdata;
+    }
+
+    parallel_slice(works, threads, 0, root->count);
+    parallel_run(works, threads, scan_range);
+}
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_PARALLEL_H_
+#define _HEAP_PARALLEL_H_
+
+#include "heap.h"
+
+/* Upper bound of workers for one bulk operation */
+#define HEAP_PARALLEL_THREADS 64
+
+/* Nodes per worker below which a bulk operation runs serially */
+#ifndef HEAP_PARALLEL_MIN
+# define HEAP_PARALLEL_MIN 65536
+#endif
+
+/*
+ * Bulk operations split the complete tree at depth log2(threads) into
+ * independent subtrees, one group of them per worker. The calling
+ * thread is one of the workers. Callbacks run concurrently and must be
+ * safe against each other, @worker tells them apart.
+ */
+typedef void (*heap_scan_t)(struct heap_node *node, unsigned int worker, void *pdata);
+
+extern void heap_build_parallel(struct heap_root *root, struct heap_node **nodes, unsigned int count,
+                                heap_cmp_t cmp, unsigned int threads);
+extern void heap_destroy_parallel(struct heap_root *root, heap_release_t release, void *pdata,
+                                  unsigned int threads);
+extern void heap_scan_parallel(struct heap_root *root, heap_scan_t scan, void *pdata, unsigned int threads);
+
+#endif  /* _HEAP_PARALLEL_H_ */
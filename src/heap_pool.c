@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_pool.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+/* malloc() alignment, every object starts on such a boundary */
+#define POOL_ALIGN _Alignof(max_align_t)
+
+/* the first word of every slab links it into pool->slabs */
+#define POOL_HEADER POOL_ALIGN
+
+/**
+ * heap_pool_init - initialize an empty pool.
+ * @pool: pool to initialize.
+ * @size: size of each object, raised to hold the free list link.
+ *
+ * Objects are aligned like malloc() memory, @size is rounded up to the
+ * same alignment so that it holds for every object of a slab.
+ */
+void heap_pool_init(struct heap_pool *pool, size_t size)
+{
+    /* every object holds at least the free list link */
+    if (size < POOL_ALIGN)
+        size = POOL_ALIGN;
+    size = (size + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1);
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->slabs = NULL;
+    pool->free = NULL;
+    pool->size = size;
+    pool->per_slab = (HEAP_POOL_SLAB - POOL_HEADER) / size;
+    if (!pool->per_slab)
+        pool->per_slab = 1;
+}
+
+/**
+ * heap_pool_destroy - release every slab of pool at once.
+ * @pool: pool to destroy.
+ *
+ * Objects are not visited, so every cache and every structure still
+ * holding objects must be abandoned before, heap_clear() does that for
+ * a heap without sifting.
+ */
+void heap_pool_destroy(struct heap_pool *pool)
+{
+    void *slab, *next;
+
+    for (slab = pool->slabs; slab; slab = next) {
+        next = *(void **)slab;
+        free(slab);
+    }
+
+    pool->slabs = NULL;
+    pool->free = NULL;
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/**
+ * heap_pool_refill - refill an empty cache and allocate from it.
+ * @cache: per-thread cache to refill.
+ *
+ * Takes up to HEAP_POOL_BATCH objects from the shared free list, or
+ * carves a fresh slab when that is empty.
+ */
+void *heap_pool_refill(struct heap_pool_cache *cache)
+{
+    struct heap_pool *pool = cache->pool;
+    unsigned int count;
+    void *object, **link;
+    char *slab;
+
+    pthread_mutex_lock(&pool->lock);
+    if ((object = pool->free)) {
+        link = &pool->free;
+        for (count = 0; *link && count < HEAP_POOL_BATCH; ++count)
+            link = *link;
+        pool->free = *link;
+        *link = NULL;
+        pthread_mutex_unlock(&pool->lock);
+        cache->count = count - 1;
+    } else {
+        pthread_mutex_unlock(&pool->lock);
+        slab = malloc(POOL_HEADER + pool->size * pool->per_slab);
+        if (unlikely(!slab))
+            return NULL;
+
+        object = slab + POOL_HEADER;
+        for (count = 1; count < pool->per_slab; ++count)
+            *(void **)(slab + POOL_HEADER + pool->size * (count - 1)) =
+                slab + POOL_HEADER + pool->size * count;
+        *(void **)(slab + POOL_HEADER + pool->size * (count - 1)) = NULL;
+
+        pthread_mutex_lock(&pool->lock);
+        *(void **)slab = pool->slabs;
+        pool->slabs = slab;
+        pthread_mutex_unlock(&pool->lock);
+        cache->count = pool->per_slab - 1;
+    }
+
+    cache->free = *(void **)object;
+
+    return object;
+}
+
+/**
+ * heap_pool_flush - return surplus objects of a cache to its pool.
+ * @cache: per-thread cache to flush.
+ *
+ * Keeps HEAP_POOL_BATCH objects in @cache and splices the rest onto the
+ * shared free list, so a thread that only frees does not hoard memory
+ * that another thread keeps allocating.
+ */
+void heap_pool_flush(struct heap_pool_cache *cache)
+{
+    struct heap_pool *pool = cache->pool;
+    void **link, *head, *tail;
+    unsigned int count;
+
+    link = &cache->free;
+    for (count = 0; *link && count < HEAP_POOL_BATCH; ++count)
+        link = *link;
+
+    if (!(head = *link))
+        return;
+
+    for (tail = head; *(void **)tail; tail = *(void **)tail)
+        ;
+
+    *link = NULL;
+    cache->count = count;
+
+    pthread_mutex_lock(&pool->lock);
+    *(void **)tail = pool->free;
+    pool->free = head;
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_POOL_H_
+#define _HEAP_POOL_H_
+
+#include "heap.h"
+#include <pthread.h>
+
+#ifndef HEAP_POOL_SLAB
+# define HEAP_POOL_SLAB 65536
+#endif
+
+#ifndef HEAP_POOL_BATCH
+# define HEAP_POOL_BATCH 64
+#endif
+
+/*
+ * Fixed-size slab pool for heap entries. Slabs are only returned in
+ * bulk by heap_pool_destroy(), objects are recycled through free lists
+ * threaded through their first word.
+ */
+struct heap_pool {
+    pthread_mutex_t lock;
+    void *slabs;
+    void *free;
+    size_t size;
+    unsigned int per_slab;
+};
+
+/*
+ * Per-thread front end of a pool, allocation and free touch only this
+ * list and fall back to the locked pool every HEAP_POOL_BATCH objects.
+ */
+struct heap_pool_cache {
+    struct heap_pool *pool;
+    void *free;
+    unsigned int count;
+};
+
+#define HEAP_POOL_CACHE_STATIC(pool) \
+    {pool, NULL, 0}
+
+#define HEAP_POOL_CACHE_INIT(pool) \
+    (struct heap_pool_cache) HEAP_POOL_CACHE_STATIC(pool)
+
+#define HEAP_POOL_CACHE(name, pool) \
+    struct heap_pool_cache name = HEAP_POOL_CACHE_INIT(pool)
+
+extern void heap_pool_init(struct heap_pool *pool, size_t size);
+extern void heap_pool_destroy(struct heap_pool *pool);
+extern void *heap_pool_refill(struct heap_pool_cache *cache);
+extern void heap_pool_flush(struct heap_pool_cache *cache);
+
+/**
+ * heap_pool_alloc - allocate one object from pool cache.
+ * @cache: per-thread cache to allocate from.
+ *
+ * Returns NULL when no slab can be allocated.
+ */
+static inline void *heap_pool_alloc(struct heap_pool_cache *cache)
+{
+    void *object = cache->free;
+
+    if (unlikely(!object))
+        return heap_pool_refill(cache);
+
+    cache->free = *(void **)object;
+    cache->count--;
+
+    return object;
+}
+
+/**
+ * heap_pool_free - give object back to pool cache.
+ * @cache: per-thread cache to free into.
+ * @object: object allocated from the same pool.
+ */
+static inline void heap_pool_free(struct heap_pool_cache *cache, void *object)
+{
+    *(void **)object = cache->free;
+    cache->free = object;
+
+    if (unlikely(++cache->count >= HEAP_POOL_BATCH * 2))
+        heap_pool_flush(cache);
+}
+
+#endif  /* _HEAP_POOL_H_ */
@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_shard.h"
+
+static __always_inline struct heap_node *
+shard_take(struct heap_shard *shard, heap_cmp_t cmp)
+{
+    struct heap_node *node = shard->root.node;
+
+    if (node)
+        heap_delete(&shard->root, node, cmp);
+
+    return node;
+}
+
+static __always_inline void
+shard_publish(struct heap_shards *set, struct heap_shard *shard)
+{
+    struct heap_node *top = shard->root.node;
+
+    if (set->key)
+        __atomic_store_n(&shard->hint, top ? set->key(top) : HEAP_SHARD_EMPTY, __ATOMIC_RELAXED);
+}
+
+static __always_inline unsigned int
+shard_victim(struct heap_shards *set, struct heap_shard *local, unsigned int index)
+{
+    unsigned int seed = local->seed;
+
+    /* xorshift, only touched under the local lock */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    local->seed = seed;
+
+    return (index + 1 + seed % (set->count - 1)) % set->count;
+}
+
+/**
+ * heap_shard_init - initialize one shard.
+ * @shard: shard to initialize.
+ * @index: index of @shard in its set, seeds victim selection.
+ */
+void heap_shard_init(struct heap_shard *shard, unsigned int index)
+{
+    pthread_mutex_init(&shard->lock, NULL);
+    shard->root = HEAP_INIT;
+    shard->seed = index * 2654435761U + 1;
+    shard->hint = HEAP_SHARD_EMPTY;
+}
+
+/**
+ * heap_shard_push - insert node into local shard.
+ * @set: shard set to insert.
+ * @index: index of the local shard.
+ * @node: new node to insert.
+ * @cmp: operator defining the node order.
+ */
+void heap_shard_push(struct heap_shards *set, unsigned int index, struct heap_node *node, heap_cmp_t cmp)
+{
+    struct heap_shard *local = set->shards[index];
+
+    pthread_mutex_lock(&local->lock);
+    heap_insert(&local->root, node, cmp);
+    if (local->root.node == node)
+        shard_publish(set, local);
+    pthread_mutex_unlock(&local->lock);
+}
+
+/**
+ * heap_shard_pop - pop the local top unless a remote shard is clearly better.
+ * @set: shard set to pop.
+ * @index: index of the local shard.
+ * @cmp: operator defining the node order.
+ *
+ * Other shards are left alone while the local one has nodes, unless the
+ * set publishes keys and a random remote hint beats the local top by
+ * more than @set->slack, that remote is then only tried without
+ * blocking. When the local shard is empty every other shard is visited
+ * in turn, so NULL means the set was empty at some point during the call.
+ */
+struct heap_node *heap_shard_pop(struct heap_shards *set, unsigned int index, heap_cmp_t cmp)
+{
+    struct heap_shard *local = set->shards[index], *remote;
+    struct heap_node *node, *steal;
+    uint64_t key, hint;
+    unsigned int count;
+
+    pthread_mutex_lock(&local->lock);
+    node = local->root.node;
+
+    if (node && set->key && set->count > 1) {
+        remote = set->shards[shard_victim(set, local, index)];
+        hint = __atomic_load_n(&remote->hint, __ATOMIC_RELAXED);
+        key = set->key(node);
+
+        if (hint < key && key - hint > set->slack && !pthread_mutex_trylock(&remote->lock)) {
+            steal = remote->root.node;
+            if (steal && cmp(steal, node) < 0) {
+                node = shard_take(remote, cmp);
+                shard_publish(set, remote);
+                pthread_mutex_unlock(&remote->lock);
+                pthread_mutex_unlock(&local->lock);
+                return node;
+            }
+            pthread_mutex_unlock(&remote->lock);
+        }
+    }
+
+    node = shard_take(local, cmp);
+    shard_publish(set, local);
+    pthread_mutex_unlock(&local->lock);
+    if (node)
+        return node;
+
+    /* never wait on a remote lock while holding the local one */
+    for (count = 1; count < set->count; ++count) {
+        remote = set->shards[(index + count) % set->count];
+        if (set->key && __atomic_load_n(&remote->hint, __ATOMIC_RELAXED) == HEAP_SHARD_EMPTY)
+            continue;
+        pthread_mutex_lock(&remote->lock);
+        node = shard_take(remote, cmp);
+        shard_publish(set, remote);
+        pthread_mutex_unlock(&remote->lock);
+        if (node)
+            return node;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_SHARD_H_
+#define _HEAP_SHARD_H_
+
+#include "heap.h"
+#include <stdint.h>
+#include <pthread.h>
+
+#define HEAP_SHARD_ALIGN 64
+
+/* Published hint of a shard with no node */
+#define HEAP_SHARD_EMPTY UINT64_MAX
+
+typedef uint64_t (*heap_shard_key_t)(const struct heap_node *node);
+
+/*
+ * One heap per core or NUMA node. Each shard sits on its own cache
+ * lines, let the owning thread allocate and initialize it so the
+ * first touch places it in local memory. @hint publishes the key of
+ * the top node on a line of its own, other shards read it without
+ * taking @lock.
+ */
+struct heap_shard {
+    pthread_mutex_t lock;
+    struct heap_root root;
+    unsigned int seed;
+    uint64_t hint __attribute__((aligned(HEAP_SHARD_ALIGN)));
+} __attribute__((aligned(HEAP_SHARD_ALIGN)));
+
+/*
+ * Without @key a pop only leaves the local shard once it is empty. With
+ * @key, each shard publishes the key of its top node, and a pop steals
+ * from a remote shard whose published key beats the local top by more
+ * than @slack. Keys must stay below HEAP_SHARD_EMPTY.
+ */
+struct heap_shards {
+    struct heap_shard **shards;
+    unsigned int count;
+    heap_shard_key_t key;
+    uint64_t slack;
+};
+
+#define HEAP_SHARDS_STATIC(shards, count) \
+    {shards, count, NULL, 0}
+
+#define HEAP_SHARDS_INIT(shards, count) \
+    (struct heap_shards) HEAP_SHARDS_STATIC(shards, count)
+
+#define HEAP_SHARDS(name, shards, count) \
+    struct heap_shards name = HEAP_SHARDS_INIT(shards, count)
+
+#define HEAP_SHARDS_KEYED_STATIC(shards, count, key, slack) \
+    {shards, count, key, slack}
+
+#define HEAP_SHARDS_KEYED_INIT(shards, count, key, slack) \
+    (struct heap_shards) HEAP_SHARDS_KEYED_STATIC(shards, count, key, slack)
+
+#define HEAP_SHARDS_KEYED(name, shards, count, key, slack) \
+    struct heap_shards name = HEAP_SHARDS_KEYED_INIT(shards, count, key, slack)
+
+extern void heap_shard_init(struct heap_shard *shard, unsigned int index);
+extern void heap_shard_push(struct heap_shards *set, unsigned int index, struct heap_node *node, heap_cmp_t cmp);
+extern struct heap_node *heap_shard_pop(struct heap_shards *set, unsigned int index, heap_cmp_t cmp);
+
+#endif  /* _HEAP_SHARD_H_ */
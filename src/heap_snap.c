@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_snap.h"
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int snap_write(int fd, const void *buff, size_t length)
+{
+    ssize_t done;
+
+    while (length) {
+        done = write(fd, buff, length);
+        if (done < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        buff = (const char *)buff + done;
+        length -= done;
+    }
+
+    return 0;
+}
+
+/**
+ * heap_snap_save - write heap contents to a snapshot file.
+ * @root: heap tree to save, left untouched.
+ * @fd: file opened for writing at the start of the snapshot.
+ * @save: fills the record of a node.
+ * @pdata: private data passed to @save.
+ */
+int heap_snap_save(struct heap_root *root, int fd, heap_snap_save_t save, void *pdata)
+{
+    struct heap_snap_record records[HEAP_SNAP_BATCH];
+    struct heap_snap_header header;
+    struct heap_node *node = root->node;
+    unsigned int index, fill = 0;
+    int retval;
+
+    header.magic = HEAP_SNAP_MAGIC;
+    header.version = HEAP_SNAP_VERSION;
+    header.count = root->count;
+    if ((retval = snap_write(fd, &header, sizeof(header))))
+        return retval;
+
+    for (index = 1; node; node = heap_next(root, node, index++)) {
+        save(node, &records[fill], pdata);
+        if (++fill < HEAP_SNAP_BATCH)
+            continue;
+        if ((retval = snap_write(fd, records, sizeof(records))))
+            return retval;
+        fill = 0;
+    }
+
+    return snap_write(fd, records, fill * sizeof(*records));
+}
+
+/**
+ * heap_snap_load - rebuild an empty heap from a snapshot file.
+ * @root: empty heap tree to load into.
+ * @fd: snapshot file opened for reading.
+ * @load: returns the node of a record, or NULL to stop loading.
+ * @pdata: private data passed to @load.
+ *
+ * Records are linked in the level order they were saved in, without
+ * any comparison. If @load gives up, @root keeps the nodes linked so
+ * far, which are still a valid heap, and -ECANCELED is returned.
+ */
+int heap_snap_load(struct heap_root *root, int fd, heap_snap_load_t load, void *pdata)
+{
+    const struct heap_snap_header *header;
+    const struct heap_snap_record *record;
+    struct heap_node *parent, *node, **link;
+    uint64_t count, index;
+    struct stat stat;
+    void *addr;
+    int retval = 0;
+
+    HEAP_CACHED_ROOT(cached);
+
+    if (root->node)
+        return -EBUSY;
+
+    if (fstat(fd, &stat))
+        return -errno;
+
+    if ((size_t)stat.st_size < sizeof(*header))
+        return -EINVAL;
+
+    addr = mmap(NULL, stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+        return -errno;
+
+    madvise(addr, stat.st_size, MADV_SEQUENTIAL);
+    header = addr;
+    count = header->count;
+
+    if (header->magic != HEAP_SNAP_MAGIC || header->version != HEAP_SNAP_VERSION ||
+        count > UINT_MAX || stat.st_size != sizeof(*header) + count * sizeof(*record)) {
+        retval = -EINVAL;
+        goto finish;
+    }
+
+    cached.root = *root;
+    record = (const void *)(header + 1);
+    for (index = 0; index < count; ++index) {
+        if (!(node = load(&record[index], pdata))) {
+            retval = -ECANCELED;
+            break;
+        }
+
+        /* level order is heap order, the free slot is all it takes */
+        link = heap_cached_parent(&cached, &parent);
+        heap_link(&cached.root, parent, link, node);
+        cached.leaf = node;
+    }
+    *root = cached.root;
+
+finish:
+    munmap(addr, stat.st_size);
+    return retval;
+}
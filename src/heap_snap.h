@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_SNAP_H_
+#define _HEAP_SNAP_H_
+
+#include "heap.h"
+#include <stdint.h>
+
+#define HEAP_SNAP_MAGIC     0x70616e73u   /* "snap" */
+#define HEAP_SNAP_VERSION   1
+
+/* Records buffered per write on save */
+#ifndef HEAP_SNAP_BATCH
+# define HEAP_SNAP_BATCH 4096
+#endif
+
+/*
+ * A snapshot is the header followed by @count records in level order
+ * of the saved heap. Every prefix of the records is a valid heap again,
+ * so the file can be mapped and read in place.
+ */
+struct heap_snap_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+};
+
+struct heap_snap_record {
+    uint64_t key;
+    uint64_t id;
+};
+
+typedef void (*heap_snap_save_t)(const struct heap_node *node, struct heap_snap_record *record, void *pdata);
+typedef struct heap_node *(*heap_snap_load_t)(const struct heap_snap_record *record, void *pdata);
+
+extern int heap_snap_save(struct heap_root *root, int fd, heap_snap_save_t save, void *pdata);
+extern int heap_snap_load(struct heap_root *root, int fd, heap_snap_load_t load, void *pdata);
+
+#endif  /* _HEAP_SNAP_H_ */
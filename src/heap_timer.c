@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright(c) 2022 Sanpe <sanpeqf@gmail.com>
+ */
+
+#include "heap_timer.h"
+
+static __always_inline long
+timer_cmp(const struct heap_node *nodea, const struct heap_node *nodeb)
+{
+    const struct heap_timer *timera = heap_to_timer(nodea);
+    const struct heap_timer *timerb = heap_to_timer(nodeb);
+    return timera->expires < timerb->expires ? -1 : 1;
+}
+
+HEAP_DEFINE(static inline, timer_heap, timer_cmp)
+
+static __always_inline void
+wheel_add(struct heap_timer_base *base, struct heap_timer *timer)
+{
+    struct heap_node *head, *node = &timer->node;
+
+    head = &base->wheel[(timer->expires >> HEAP_TIMER_SLOT_SHIFT) & HEAP_TIMER_MASK];
+    node->parent = HEAP_TIMER_WHEELED;
+    node->left = head;
+    node->right = head->right;
+    head->right->left = node;
+    head->right = node;
+    base->wheeled++;
+}
+
+static __always_inline void
+wheel_del(struct heap_timer_base *base, struct heap_timer *timer)
+{
+    struct heap_node *node = &timer->node;
+
+    node->right->left = node->left;
+    node->left->right = node->right;
+    base->wheeled--;
+}
+
+static void wheel_promote(struct heap_timer_base *base, struct heap_node *head, unsigned long slot)
+{
+    struct heap_node *node, *next;
+    struct heap_timer *timer;
+
+    for (node = head->left; node != head; node = next) {
+        next = node->left;
+        timer = heap_to_timer(node);
+
+        /* later rounds of the wheel stay parked */
+        if ((timer->expires >> HEAP_TIMER_SLOT_SHIFT) > slot)
+            continue;
+
+        wheel_del(base, timer);
+        timer_heap_insert(&base->heap, node);
+    }
+}
+
+static void wheel_advance(struct heap_timer_base *base, unsigned long now)
+{
+    unsigned long slot, last;
+
+    slot = (base->clock >> HEAP_TIMER_SLOT_SHIFT) + 2;
+    last = (now >> HEAP_TIMER_SLOT_SHIFT) + 1;
+    base->clock = now;
+
+    if (!base->wheeled || slot > last)
+        return;
+
+    /* a full revolution visits every slot once */
+    if (last - slot >= HEAP_TIMER_MASK)
+        slot = last - HEAP_TIMER_MASK;
+
+    for (; slot <= last; ++slot)
+        wheel_promote(base, &base->wheel[slot & HEAP_TIMER_MASK], last);
+}
+
+/**
+ * heap_timer_init - initialize timer base.
+ * @base: timer base to initialize.
+ * @now: current time in ticks.
+ */
+void heap_timer_init(struct heap_timer_base *base, unsigned long now)
+{
+    unsigned long slot;
+
+    base->heap = HEAP_INIT;
+    base->clock = now;
+    base->wheeled = 0;
+
+    for (slot = 0; slot < HEAP_TIMER_SLOTS; ++slot)
+        base->wheel[slot].left = base->wheel[slot].right = &base->wheel[slot];
+}
+
+/**
+ * heap_timer_add - arm timer at @timer->expires.
+ * @base: timer base to arm on.
+ * @timer: timer to arm.
+ *
+ * Timers due within the next slot go straight into the heap, far ones
+ * are parked in the wheel in O(1).
+ */
+void heap_timer_add(struct heap_timer_base *base, struct heap_timer *timer)
+{
+    unsigned long slot = timer->expires >> HEAP_TIMER_SLOT_SHIFT;
+
+    if (slot <= (base->clock >> HEAP_TIMER_SLOT_SHIFT) + 1)
+        timer_heap_insert(&base->heap, &timer->node);
+    else
+        wheel_add(base, timer);
+}
+
+/**
+ * heap_timer_cancel - disarm pending timer.
+ * @base: timer base of timer.
+ * @timer: timer to cancel.
+ */
+void heap_timer_cancel(struct heap_timer_base *base, struct heap_timer *timer)
+{
+    if (!heap_timer_wheeled(timer)) {
+        timer_heap_delete(&base->heap, &timer->node);
+        return;
+    }
+
+    wheel_del(base, timer);
+    timer->node.left = POISON_HPNODE1;
+    timer->node.right = POISON_HPNODE2;
+    timer->node.parent = POISON_HPNODE3;
+}
+
+/**
+ * heap_timer_expire - advance the clock and pop one expired timer.
+ * @base: timer base to expire.
+ * @now: current time in ticks, never going backward.
+ *
+ * Returns NULL when no timer expires at or before @now.
+ */
+struct heap_timer *heap_timer_expire(struct heap_timer_base *base, unsigned long now)
+{
+    struct heap_timer *timer;
+
+    if (now != base->clock)
+        wheel_advance(base, now);
+
+    if (!base->heap.node)
+        return NULL;
+
+    timer = heap_to_timer(base->heap.node);
+    if (timer->expires > now)
+        return NULL;
+
+    timer_heap_delete(&base->heap, &timer->node);
+    return timer;
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _HEAP_TIMER_H_
+#define _HEAP_TIMER_H_
+
+#include "heap.h"
+
+/* Ticks covered by one wheel slot, as a power of two */
+#ifndef HEAP_TIMER_SLOT_SHIFT
+# define HEAP_TIMER_SLOT_SHIFT 6
+#endif
+
+/* Number of wheel slots, as a power of two */
+#ifndef HEAP_TIMER_WHEEL_SHIFT
+# define HEAP_TIMER_WHEEL_SHIFT 8
+#endif
+
+#define HEAP_TIMER_SLOTS (1UL << HEAP_TIMER_WHEEL_SHIFT)
+#define HEAP_TIMER_MASK (HEAP_TIMER_SLOTS - 1)
+
+/* Parent of a timer parked in the wheel rather than in the heap */
+#define HEAP_TIMER_WHEELED ((void *) POISON_OFFSET + 0x40)
+
+struct heap_timer {
+    struct heap_node node;
+    unsigned long expires;
+};
+
+/*
+ * Timers due within the next slot are kept exactly ordered in @heap,
+ * the rest wait in a hashed wheel of circular lists, linked through
+ * &heap_node.left (next) and &heap_node.right (prev), and are promoted
+ * when their slot comes within reach.
+ */
+struct heap_timer_base {
+    struct heap_root heap;
+    unsigned long clock;
+    unsigned int wheeled;
+    struct heap_node wheel[HEAP_TIMER_SLOTS];
+};
+
+#define heap_to_timer(ptr) \
+    heap_entry(ptr, struct heap_timer, node)
+
+#define HEAP_TIMER_COUNT(base) \
+    ((base)->heap.count + (base)->wheeled)
+
+extern void heap_timer_init(struct heap_timer_base *base, unsigned long now);
+extern void heap_timer_add(struct heap_timer_base *base, struct heap_timer *timer);
+extern void heap_timer_cancel(struct heap_timer_base *base, struct heap_timer *timer);
+extern struct heap_timer *heap_timer_expire(struct heap_timer_base *base, unsigned long now);
+
+/**
+ * heap_timer_wheeled - check whether timer is parked in the wheel.
+ * @timer: pending timer to check.
+ */
+static inline bool heap_timer_wheeled(const struct heap_timer *timer)
+{
+    return timer->node.parent == HEAP_TIMER_WHEELED;
+}
+
+#endif  /* _HEAP_TIMER_H_ */